@@ -0,0 +1,98 @@
+#include "core/catalog.h"
+#include "../utils.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace core;
+
+namespace {
+    constexpr size_t NB_MOVIES = 20000;
+    constexpr size_t SYNOPSIS_SIZE = 1000;
+    constexpr size_t CACHE_SIZE = 100;
+    constexpr const char *CSV_FILE = "./bench_catalog.csv";
+}
+
+// resident memory of this process, in KiB
+static size_t resident_kib() {
+    ifstream statm("/proc/self/statm");
+    size_t size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// run f in a child process, so that each measure starts from the same
+// (small) heap
+static void in_child(function<void()> f) {
+    cout.flush();
+    pid_t pid = fork();
+    if (pid != 0) {
+        waitpid(pid, nullptr, 0);
+        return;
+    }
+    f();
+    cout.flush();
+    _exit(0);
+}
+
+// load time and resident memory of a catalog, then time to read 10
+// synopses spread over the file
+static void measure(const string &name, unique_ptr<BasicCatalog> (*load)()) {
+    size_t before = resident_kib();
+    unique_ptr<BasicCatalog> catalog;
+    double t = bench::measure([&]() { catalog = load(); }, 1);
+    size_t resident = resident_kib() - before;
+    bench::report("load/" + name, catalog->size(), t);
+    cout << left << setw(32) << ("resident/" + name) << right << setw(10)
+         << catalog->size() << setw(14) << resident << " KiB" << endl;
+
+    size_t n = 0;
+    vector<data::movie_ref> movies = catalog->all_movies();
+    t = bench::measure([&]() {
+        for (size_t i = 0; i < movies.size(); i += movies.size() / 10)
+            n += movies[i].get().synopsis().size();
+    }, 1);
+    bench::report("10 synopses/" + name, catalog->size(), t);
+}
+
+// memory and load time of the catalogs, on movies with 1000 bytes synopses
+int main(void) {
+    in_child([]() {
+        auto movies = bench::create_movies(NB_MOVIES);
+        BasicCatalog catalog;
+        for (size_t i = 0; i < movies.size(); i++) {
+            movies[i]->set_synopsis(string(SYNOPSIS_SIZE, 'a' + i % 26));
+            catalog.add(move(movies[i]));
+        }
+        catalog.save(CSV_FILE);
+    });
+
+    in_child([]() {
+        measure("basic", []() -> unique_ptr<BasicCatalog> {
+            return make_unique<BasicCatalog>(CSV_FILE);
+        });
+    });
+    in_child([]() {
+        measure("cached", []() -> unique_ptr<BasicCatalog> {
+            return make_unique<CachedCatalog>(CSV_FILE, CACHE_SIZE);
+        });
+    });
+    in_child([]() {
+        measure("paged", []() -> unique_ptr<BasicCatalog> {
+            return make_unique<PagedCachedCatalog>(CSV_FILE, CACHE_SIZE);
+        });
+    });
+    in_child([]() {
+        measure("lazy", []() -> unique_ptr<BasicCatalog> {
+            return make_unique<LazyCatalog>(CSV_FILE, CACHE_SIZE);
+        });
+    });
+
+    remove(CSV_FILE);
+    return 0;
+}
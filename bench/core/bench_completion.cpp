@@ -0,0 +1,65 @@
+#include "core/completion.h"
+#include "core/utils.h"
+#include "../utils.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace core;
+
+namespace {
+    constexpr size_t NB_MOVIES = 100000;
+    constexpr size_t NB_SUGGESTIONS = 10;
+}
+
+// suggestions for a prefix: scan of all movies vs completion index
+int main(void) {
+    auto collection = bench::create_movies(NB_MOVIES);
+    auto movies = bench::refs(collection);
+    Completion completion;
+    size_t n = 0;
+
+    double t = bench::measure([&]() {
+        completion.clear();
+        for (data::movie_ref m: movies) completion.add(m.get());
+        n = completion.size();
+    }, 1);
+    bench::report("build", movies.size(), t);
+
+    t = bench::measure([&]() { n = completion.suggest("a", 1).size(); }, 1);
+    bench::report("first suggest (sort)", movies.size(), t);
+
+    t = bench::measure([&]() {
+        string p = slug("dir");
+        n = 0;
+        for (data::movie_ref m: movies)
+            if (slug(m.get().director()).compare(0, p.size(), p) == 0) n++;
+    });
+    bench::report("scan/director prefix", movies.size(), t);
+
+    // short prefixes match many entries
+    for (string prefix: {"a", "ab", "dir", "actor 12", "director 4"}) {
+        t = bench::measure([&]() {
+            n = completion.suggest(prefix, NB_SUGGESTIONS).size();
+        }, 100);
+        bench::report("suggest \"" + prefix + "\"", movies.size(), t);
+    }
+
+    string title = movies[0].get().title();
+    t = bench::measure([&]() {
+        completion.remove(title);
+        completion.add(movies[0].get());
+        n = completion.suggest("a", NB_SUGGESTIONS).size();
+    });
+    bench::report("update + suggest", movies.size(), t);
+
+    // a new title is merged into the sorted entries
+    auto extra = bench::create_movies(1, 7);
+    t = bench::measure([&]() {
+        completion.add(*extra[0]);
+        n = completion.suggest("a", NB_SUGGESTIONS).size();
+        completion.remove(extra[0]->title());
+    });
+    bench::report("new movie + suggest", movies.size(), t);
+    return 0;
+}
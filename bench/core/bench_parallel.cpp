@@ -0,0 +1,49 @@
+#include "core/sort.h"
+#include "core/parallel.h"
+#include "../utils.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace core;
+
+// sort and selection time by catalog size and number of threads, and cost
+// of starting the threads (to choose parallel::threshold)
+int main(void) {
+    parallel::set_threshold(0);
+
+    for (size_t t = 2; t <= 8; t *= 2) {
+        double us = bench::measure([&]() {
+            parallel::for_chunks(t, t, [](size_t, size_t, size_t) {});
+        }, 100);
+        bench::report("for_chunks/empty/" + to_string(t) + "t", t, us);
+    }
+
+    for (size_t n: {10000, 100000, 1000000}) {
+        auto collection = bench::create_movies(n);
+        auto movies = bench::refs(collection);
+
+        for (size_t t = 1; t <= 4; t++) {
+            parallel::set_nb_threads(t);
+            string suffix = "/" + to_string(t) + "t";
+            vector<data::movie_ref> v;
+
+            double us = bench::measure([&]() {
+                v = movies;
+                sorting::sort(v, sorting::sort_by_title(true));
+            }, 3);
+            bench::report("sort/title" + suffix, n, us);
+
+            us = bench::measure([&]() {
+                v = selection::select_by_category(movies, "Drame");
+            }, 3);
+            bench::report("select_by_category" + suffix, n, us);
+
+            us = bench::measure([&]() {
+                v = selection::select_by_year(movies, 1990, 5);
+            }, 3);
+            bench::report("select_by_year" + suffix, n, us);
+        }
+    }
+    return 0;
+}
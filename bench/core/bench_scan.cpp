@@ -0,0 +1,62 @@
+#include "core/scan.h"
+#include "core/catalog.h"
+#include "../utils.h"
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace core;
+
+namespace {
+    constexpr size_t NB_VALUES = 1000000;
+    constexpr size_t NB_MOVIES = 100000;
+}
+
+// range scan of a dense column with each supported kernel
+void bench_kernels() {
+    mt19937 gen(42);
+    uniform_int_distribution<int> year(1920, 2025);
+    vector<int> values(NB_VALUES);
+    for (auto &v: values) v = year(gen);
+
+    string names[] = {"scalar", "sse2", "avx2", "neon"};
+    for (scan::kernel k: {scan::SCALAR, scan::SSE2, scan::AVX2, scan::NEON}) {
+        if (!scan::supported(k)) continue;
+        vector<uint32_t> res;
+
+        // selective (about 1%) and wide (about 20%) intervals
+        double t = bench::measure([&]() {
+            res = scan::range(k, values.data(), values.size(), 1990, 1990);
+        });
+        bench::report("scan/" + names[k] + "/1%", values.size(), t);
+
+        t = bench::measure([&]() {
+            res = scan::range(k, values.data(), values.size(), 1980, 2000);
+        });
+        bench::report("scan/" + names[k] + "/20%", values.size(), t);
+    }
+}
+
+// selection over movies vs scan of the catalog dense column
+void bench_catalog() {
+    auto collection = bench::create_movies(NB_MOVIES);
+    auto movies = bench::refs(collection);
+    BasicCatalog catalog;
+    catalog.add_bulk(move(collection));
+    vector<data::movie_ref> v;
+
+    double t = bench::measure([&]() {
+        v = selection::select_by_duration(movies, 120, 5);
+    });
+    bench::report("select_by_duration", movies.size(), t);
+
+    t = bench::measure([&]() { v = catalog.movies_by_duration(120, 5); });
+    bench::report("catalog.movies_by_duration", movies.size(), t);
+}
+
+int main(void) {
+    bench_kernels();
+    bench_catalog();
+    return 0;
+}
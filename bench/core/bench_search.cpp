@@ -0,0 +1,136 @@
+#include "core/search.h"
+#include "core/parallel.h"
+#include "core/sort.h"
+#include "../utils.h"
+
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+using namespace core;
+
+namespace {
+    constexpr size_t NB_MOVIES = 20000;
+    constexpr const char *DB_PATH = "./bench_index_db";
+}
+
+// full reindex: one add per movie (autoflush) vs batched transactions,
+// with documents prepared on one or several threads
+int main(void) {
+    auto collection = bench::create_movies(NB_MOVIES);
+    auto movies = bench::refs(collection);
+
+    {
+        search::Indexer index(DB_PATH, "french");
+        double t = bench::measure([&]() {
+            index.clear();
+            for (auto &m: movies) index.add(m);
+            index.flush();
+        }, 1);
+        bench::report("reindex/add per movie", movies.size(), t);
+
+        // sequential preparation
+        parallel::set_nb_threads(1);
+        for (size_t batch: {10, 100, 1000, 10000}) {
+            t = bench::measure([&]() { index.reindex_all(movies, batch); }, 1);
+            bench::report("reindex_all/batch " + to_string(batch),
+                          movies.size(), t);
+        }
+
+        // scaling of the parallel preparation on 1 to 4 threads
+        parallel::set_nb_threads(0);
+        parallel::set_threshold(1);
+        for (size_t w = 1; w <= 4; w++) {
+            index.set_nb_workers(w);
+            t = bench::measure([&]() { index.reindex_all(movies); }, 1);
+            bench::report("reindex_all/" + to_string(w) + " threads",
+                          movies.size(), t);
+        }
+        index.set_nb_workers(0);
+        parallel::set_threshold(20000);
+
+        // nightly pass on an unchanged library, then with 1% of changes
+        t = bench::measure([&]() {
+            index.reindex_all(movies, search::Indexer::DEFAULT_BATCH_SIZE,
+                              nullptr, search::INCREMENTAL);
+        }, 1);
+        bench::report("reindex_all/incremental, unchanged", movies.size(), t);
+
+        for (size_t i = 0; i < movies.size(); i += 100)
+            movies[i].get().set_duration(movies[i].get().duration() + 1);
+        t = bench::measure([&]() {
+            index.reindex_all(movies, search::Indexer::DEFAULT_BATCH_SIZE,
+                              nullptr, search::INCREMENTAL);
+        }, 1);
+        bench::report("reindex_all/incremental, 1% changed", movies.size(), t);
+
+        size_t n = 0;
+        t = bench::measure([&]() { index.flush(); n = index.stats().nb_terms; });
+        bench::report("stats (after commit)", movies.size(), t);
+
+        t = bench::measure([&]() { n = index.stats().nb_terms; });
+        bench::report("stats (cached)", movies.size(), t);
+
+        // repeated query, with and without the results cache
+        vector<pair<string, double>> res;
+        t = bench::measure([&]() { res = index.search("Drame 1990", 24); }, 100);
+        bench::report("search (cached)", movies.size(), t);
+
+        search::Indexer uncached(string(DB_PATH) + "_uncached", "french", 0);
+        uncached.add_bulk(movies);
+        t = bench::measure([&]() { res = uncached.search("Drame 1990", 24); }, 100);
+        bench::report("search (no cache)", movies.size(), t);
+
+        // page 5 of 10 results: fetch 50 results vs offset
+        t = bench::measure([&]() { res = uncached.search("Drame", 50); }, 100);
+        bench::report("page 5/first 50 results", movies.size(), t);
+
+        t = bench::measure([&]() {
+            res = uncached.search_page("Drame", 40, 10).results;
+        }, 100);
+        bench::report("page 5/offset", movies.size(), t);
+
+        // first page of the dramas of the 90s by year: all results
+        // post-filtered with selection vs filter and sort inside the match
+        unordered_map<string, data::movie_ref> by_title;
+        for (auto &m: movies) by_title.emplace(m.get().title(), m);
+        t = bench::measure([&]() {
+            vector<data::movie_ref> v;
+            for (auto &r: uncached.search("Drame", movies.size()))
+                v.push_back(by_title.at(r.first));
+            v = selection::select_by_year(v, 1995, 5);
+            sorting::top_k(v, 24, sorting::sort_by_year());
+        }, 10);
+        bench::report("filter+sort/post-filter", movies.size(), t);
+
+        t = bench::measure([&]() {
+            res = uncached.search_page(
+                "category:drame year:1990..2000", 0, 24, search::YEAR_DESC
+            ).results;
+        }, 10);
+        bench::report("filter+sort/in the match", movies.size(), t);
+
+        // 100 searches per thread, on the pool of read-only handles
+        size_t nb_threads = parallel::nb_threads();
+        t = bench::measure([&]() {
+            vector<thread> searchers;
+            for (size_t i = 0; i < nb_threads; i++)
+                searchers.emplace_back([&uncached]() {
+                    for (size_t j = 0; j < 100; j++)
+                        uncached.search("Drame 1990", 24);
+                });
+            for (auto &th: searchers) th.join();
+        }, 1);
+        bench::report("search x100 (" + to_string(nb_threads) + " threads)",
+                      movies.size(), t);
+
+        t = bench::measure([&]() { index.clear(); }, 1);
+        bench::report("clear", movies.size(), t);
+    }
+
+    filesystem::remove_all(DB_PATH);
+    filesystem::remove_all(string(DB_PATH) + "_uncached");
+    return 0;
+}
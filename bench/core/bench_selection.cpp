@@ -0,0 +1,116 @@
+#include "core/sort.h"
+#include "core/catalog.h"
+#include "core/utils.h"
+#include "../utils.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace core;
+
+namespace {
+    constexpr size_t NB_MOVIES = 100000;
+    constexpr size_t PAGE_SIZE = 24;
+}
+
+// chained select_by_* calls vs a lazy query (whole result and first page)
+int main(void) {
+    auto collection = bench::create_movies(NB_MOVIES);
+    auto movies = bench::refs(collection);
+    vector<data::movie_ref> v;
+
+    double t = bench::measure([&]() {
+        v = selection::select_by_category(movies, "Drame");
+        v = selection::select_by_year(v, 1990, 10);
+        v = selection::select_by_duration(v, 120, 30);
+    });
+    bench::report("chained select_by", movies.size(), t);
+
+    auto q = selection::Query().category("Drame").year(1990, 10)
+        .duration(120, 30);
+
+    t = bench::measure([&]() { v = q.run(movies); });
+    bench::report("query/all", movies.size(), t);
+
+    t = bench::measure([&]() { v = q.run(movies, 0, PAGE_SIZE); });
+    bench::report("query/first page", movies.size(), t);
+
+    t = bench::measure([&]() { v = q.run(movies, 10 * PAGE_SIZE, PAGE_SIZE); });
+    bench::report("query/page 11", movies.size(), t);
+
+    // accent and case insensitive match: slug per movie vs precomputed keys
+    t = bench::measure([&]() {
+        string key = slug("drame");
+        v.clear();
+        for (data::movie_ref m: movies)
+            if (slug(m.get().category()) == key) v.push_back(m);
+    });
+    bench::report("normalized/slug per movie", movies.size(), t);
+
+    t = bench::measure([&]() {
+        v = selection::select_by_category(movies, "drame", selection::NORMALIZED);
+    });
+    bench::report("normalized/precomputed keys", movies.size(), t);
+
+    // bitmap indexes of the catalog (years are bitmap buckets: no duration)
+    BasicCatalog catalog;
+    catalog.add_bulk(move(collection));
+    size_t n = 0;
+
+    t = bench::measure([&]() {
+        n = (catalog.category_bitmap("Drame") & catalog.year_bitmap(1980, 2000))
+            .cardinality();
+    });
+    bench::report("bitmap/count", movies.size(), t);
+
+    t = bench::measure([&]() {
+        v = catalog.movies_in(
+            catalog.category_bitmap("Drame") & catalog.year_bitmap(1980, 2000),
+            0, PAGE_SIZE);
+    });
+    bench::report("bitmap/first page", movies.size(), t);
+
+    t = bench::measure([&]() {
+        Bitmap b = catalog.category_bitmap("Drame");
+        b |= catalog.category_bitmap("Policier");
+        n = (b & catalog.director_bitmap("director 42")).cardinality();
+    });
+    bench::report("bitmap/or+and count", movies.size(), t);
+
+    t = bench::measure([&]() {
+        v = selection::select_by_category(movies, "Drame");
+        v = selection::select_by_year(v, 1990, 10);
+    });
+    bench::report("chained select_by (same)", movies.size(), t);
+
+    // facets: one selection per category vs single pass vs catalog cache
+    selection::Facets f = selection::facets(movies);
+    t = bench::measure([&]() {
+        for (auto &[category, count]: f.categories)
+            n = selection::select_by_category(movies, category).size();
+    });
+    bench::report("facets/select_by per category", movies.size(), t);
+
+    t = bench::measure([&]() { f = selection::facets(movies); });
+    bench::report("facets/single pass", movies.size(), t);
+
+    string title = movies[0].get().title();
+    t = bench::measure([&]() {
+        catalog.refresh(title);
+        n = catalog.facets()->total;
+    });
+    bench::report("facets/catalog (changed)", movies.size(), t);
+
+    t = bench::measure([&]() { n = catalog.facets()->total; });
+    bench::report("facets/catalog (cached)", movies.size(), t);
+
+    // actors: scan of the parsed lists vs inverted index
+    t = bench::measure([&]() {
+        v = selection::select_by_actor(movies, "actor 42");
+    });
+    bench::report("actor/select_by_actor", movies.size(), t);
+
+    t = bench::measure([&]() { v = catalog.movies_by_actor("actor 42"); });
+    bench::report("actor/catalog index", movies.size(), t);
+    return 0;
+}
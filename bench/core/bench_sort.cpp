@@ -0,0 +1,124 @@
+#include "core/sort.h"
+#include "../utils.h"
+
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+using namespace core;
+
+namespace {
+    constexpr size_t NB_MOVIES = 100000;
+    constexpr size_t PAGE_SIZE = 24;
+}
+
+// full sort vs partial sorts, for the first page and a deep page
+void bench_partial_sort(const vector<data::movie_ref> &movies) {
+    sorting::sort_func cmp[] = {
+        sorting::sort_by_title(true), sorting::sort_by_year(false)
+    };
+    string names[] = {"title", "year"};
+
+    for (size_t i = 0; i < 2; i++) {
+        vector<data::movie_ref> v;
+
+        double t = bench::measure([&]() {
+            v = movies;
+            sorting::sort(v, cmp[i]);
+        });
+        bench::report("sort/" + names[i], movies.size(), t);
+
+        t = bench::measure([&]() {
+            v = movies;
+            sorting::top_k(v, PAGE_SIZE, cmp[i]);
+        });
+        bench::report("top_k/" + names[i], movies.size(), t);
+
+        t = bench::measure([&]() {
+            v = movies;
+            sorting::sort_range(v, movies.size() / 2, PAGE_SIZE, cmp[i]);
+        });
+        bench::report("sort_range(n/2)/" + names[i], movies.size(), t);
+    }
+}
+
+// comparator sort vs key extraction sort
+void bench_key_sort(const vector<data::movie_ref> &movies) {
+    sorting::field fields[] = {
+        sorting::TITLE, sorting::YEAR, sorting::CATEGORY, sorting::DIRECTOR
+    };
+    string names[] = {"title", "year", "category", "director"};
+
+    for (size_t i = 0; i < 4; i++) {
+        vector<data::movie_ref> v;
+
+        double t = bench::measure([&]() {
+            v = movies;
+            sorting::sort(v, sorting::sort_by(fields[i], true));
+        });
+        bench::report("sort(cmp)/" + names[i], movies.size(), t);
+
+        t = bench::measure([&]() {
+            v = movies;
+            sorting::sort(v, fields[i], true);
+        });
+        bench::report("sort(keys)/" + names[i], movies.size(), t);
+    }
+}
+
+// function pointer comparator vs composed (inlined) comparator
+void bench_composed_sort(const vector<data::movie_ref> &movies) {
+    vector<data::movie_ref> v;
+
+    double t = bench::measure([&]() {
+        v = movies;
+        sorting::sort(v, sorting::sort_by_year(false));
+    });
+    bench::report("sort(sort_func)/year", movies.size(), t);
+
+    t = bench::measure([&]() {
+        v = movies;
+        sorting::sort(v, sorting::by(&data::Movie::year, sorting::desc)
+                             .then(&data::Movie::title));
+    });
+    bench::report("sort(composed)/year", movies.size(), t);
+}
+
+// comparison sorts vs radix sort, for growing sizes (crossover point)
+void bench_radix_sort() {
+    sorting::field fields[] = {sorting::TITLE, sorting::YEAR, sorting::DURATION};
+    string names[] = {"title", "year", "duration"};
+
+    for (size_t n: {100, 1000, 10000, 100000, 1000000}) {
+        auto collection = bench::create_movies(n);
+        auto movies = bench::refs(collection);
+        size_t runs = (n >= 1000000) ? 2 : 5;
+
+        for (size_t i = 0; i < 3; i++) {
+            vector<data::movie_ref> v;
+
+            double t = bench::measure([&]() {
+                v = movies;
+                std::sort(v.begin(), v.end(), sorting::sort_by(fields[i], true));
+            }, runs);
+            bench::report("std::sort/" + names[i], n, t);
+
+            t = bench::measure([&]() {
+                v = movies;
+                sorting::radix_sort(v, fields[i], true);
+            }, runs);
+            bench::report("radix_sort/" + names[i], n, t);
+        }
+    }
+}
+
+int main(void) {
+    auto collection = bench::create_movies(NB_MOVIES);
+    auto movies = bench::refs(collection);
+
+    bench_partial_sort(movies);
+    bench_key_sort(movies);
+    bench_composed_sort(movies);
+    bench_radix_sort();
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "utils.h"
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <iomanip>
+
+std::vector<std::unique_ptr<core::data::Movie>> bench::create_movies(
+    size_t n, unsigned seed
+) {
+    static const std::vector<std::string> categories = {
+        "Drame", "Comédie", "Comédie dramatique", "Policier", "Western",
+        "Science-fiction", "Animation", "Documentaire", "Horreur", "Aventure"
+    };
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> year(1920, 2025);
+    std::uniform_int_distribution<int> duration(60, 200);
+    std::uniform_int_distribution<size_t> category(0, categories.size() - 1);
+    std::uniform_int_distribution<size_t> director(0, n / 8 + 1);
+    std::uniform_int_distribution<int> letter('a', 'z');
+
+    std::vector<std::unique_ptr<core::data::Movie>> movies;
+    movies.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        std::string title;
+        for (int j = 0; j < 12; j++) title += (char) letter(gen);
+        title += " " + std::to_string(i);
+
+        // two actors among n/4, without drawing (keeps the other values)
+        std::string actors = "actor " + std::to_string(i % (n / 4 + 1))
+            + ", actor " + std::to_string(i * 7 % (n / 4 + 1));
+
+        movies.push_back(std::make_unique<core::data::Movie>(
+            title, year(gen), categories[category(gen)], "producer",
+            "director " + std::to_string(director(gen)), actors,
+            duration(gen), "", core::data::Cover(), ""
+        ));
+    }
+    return movies;
+}
+
+std::vector<core::data::movie_ref> bench::refs(
+    const std::vector<std::unique_ptr<core::data::Movie>> &movies
+) {
+    std::vector<core::data::movie_ref> v;
+    v.reserve(movies.size());
+    for (auto &m: movies) v.push_back(std::ref(*m));
+    return v;
+}
+
+double bench::measure(std::function<void()> f, size_t runs) {
+    double total = 0;
+    for (size_t i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        total += std::chrono::duration<double, std::micro>(end - start).count();
+    }
+    return total / runs;
+}
+
+void bench::report(const std::string &name, size_t n, double us) {
+    std::cout << std::left << std::setw(32) << name
+              << std::right << std::setw(10) << n
+              << std::setw(14) << std::fixed << std::setprecision(1) << us
+              << " us" << std::endl;
+}
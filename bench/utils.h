@@ -0,0 +1,27 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <vector>
+#include <string>
+#include <functional>
+
+#include "core/movie.h"
+
+namespace bench
+{
+    // n pseudo-random movies (same collection for a given seed)
+    std::vector<std::unique_ptr<core::data::Movie>> create_movies(
+        size_t n, unsigned seed = 42);
+
+    // references to the movies
+    std::vector<core::data::movie_ref> refs(
+        const std::vector<std::unique_ptr<core::data::Movie>> &movies);
+
+    // mean duration of f in microseconds, over `runs` runs
+    double measure(std::function<void()> f, size_t runs = 5);
+
+    // print a result line: "<name> <n> <time> us"
+    void report(const std::string &name, size_t n, double us);
+} // namespace bench
+
+#endif
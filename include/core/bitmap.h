@@ -0,0 +1,124 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+/**
+ * \file bitmap.h
+ * \brief Defines a compressed set of integers (roaring bitmap).
+ */
+
+namespace core {
+
+    /**
+     * \class Bitmap
+     * \brief Compressed set of 32 bits integers, with fast intersections
+     *        and unions.
+     *
+     * Integers are grouped by their 16 high bits. Each group is stored in a
+     * container: a sorted array of the 16 low bits while the group is sparse
+     * (up to 4096 values), a 65536 bits bitset otherwise. A bitset goes back
+     * to an array below 3584 values only, so that a group oscillating around
+     * 4096 values is not converted at each change. Intersections and
+     * unions work container by container, and the cardinality is kept by
+     * each container (bitsets are counted with popcount).
+     */
+    class Bitmap {
+    public:
+        /// Construct an empty bitmap.
+        Bitmap() = default;
+
+        /**
+         * \brief Add an integer (nothing happens if already present).
+         * \param x Integer to add.
+         */
+        void add(uint32_t x);
+
+        /**
+         * \brief Remove an integer (nothing happens if absent).
+         * \param x Integer to remove.
+         */
+        void remove(uint32_t x);
+
+        /**
+         * \brief  Check if an integer is present.
+         * \param  x Integer to check.
+         * \return True if \p x is in the bitmap.
+         */
+        bool contains(uint32_t x) const;
+
+        /**
+         * \brief  Get the number of integers in the bitmap.
+         * \return Number of integers.
+         */
+        size_t cardinality() const;
+
+        /// Check if the bitmap is empty.
+        bool empty() const;
+
+        /**
+         * \brief Call a function for each integer, in increasing order.
+         * \param f Function called with each integer, returning false to
+         *          stop the iteration.
+         */
+        void for_each(const std::function<bool(uint32_t)> &f) const;
+
+        /**
+         * \brief  Get all integers.
+         * \return Integers in increasing order.
+         */
+        std::vector<uint32_t> values() const;
+
+        /// Intersection of two bitmaps.
+        Bitmap operator&(const Bitmap &other) const;
+
+        /// Union of two bitmaps.
+        Bitmap operator|(const Bitmap &other) const;
+
+        /// Keep only the integers also present in \p other.
+        Bitmap &operator&=(const Bitmap &other);
+
+        /// Add all integers of \p other.
+        Bitmap &operator|=(const Bitmap &other);
+
+        /**
+         * \brief  Union of several bitmaps at once.
+         * 
+         * Faster than successive unions: each group of integers is
+         * accumulated in a single bitset instead of merging arrays again
+         * and again.
+         * 
+         * \param  bitmaps Bitmaps to unite.
+         * \return Union of all bitmaps.
+         */
+        static Bitmap union_of(const std::vector<const Bitmap*> &bitmaps);
+
+        /// Check if both bitmaps contain the same integers.
+        bool operator==(const Bitmap &other) const;
+
+    private:
+        /// Integers sharing the same 16 high bits.
+        struct container {
+            uint16_t key;                ///< High bits.
+            uint32_t cardinality;        ///< Number of integers.
+            std::vector<uint16_t> array; ///< Sorted low bits (sparse).
+            std::vector<uint64_t> bits;  ///< Bitset of low bits (dense).
+
+            bool is_bitset() const { return !bits.empty(); }
+        };
+
+        /// Convert a container to the right representation for its size.
+        static void normalize(container &c);
+
+        static container intersect(const container &c1, const container &c2);
+        static container unite(const container &c1, const container &c2);
+
+        /// Containers, sorted by key, never empty.
+        std::vector<container> _containers;
+    };
+
+} // namespace core
+
+#endif // BITMAP_H
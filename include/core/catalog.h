@@ -2,12 +2,17 @@
 #define CATALOG_H
 
 #include <unordered_map>
+#include <map>
+#include <array>
 #include <vector>
 #include <string>
 #include <optional>
 #include <functional>
+#include <memory>
 
 #include "core/movie.h"
+#include "core/sort.h"
+#include "core/bitmap.h"
 
 /**
  * \file catalog.h
@@ -17,6 +22,7 @@
  * - BasicCatalog: stores movies without caching.
  * - CachedCatalog: adds an LRU cache for synopses (not paged).
  * - PagedCachedCatalog: adds a paged LRU cache for synopses (10 movies per page).
+ * - LazyCatalog: like CachedCatalog, but synopses are read by offset.
  */
 namespace core {
 
@@ -102,6 +108,7 @@ namespace core {
          * \brief Save catalog contents to a CSV file.
          * \param filename Path to the output CSV file.
          * \throw std::runtime_error If the CSV file cannot be opened.
+         * \note  \c saved is called once the file is written.
          */
         void save(const std::string &filename) const;
 
@@ -114,6 +121,19 @@ namespace core {
          */
         virtual void add(std::unique_ptr<data::Movie> m);
 
+        /**
+         * \brief Add several movies to the catalog at once.
+         * 
+         * Movies whose title already exists in the catalog, or appears 
+         * earlier in the batch, are not added.
+         * 
+         * \param movies Movies to add (takes ownership).
+         * \return References to the movies actually added (non-owning),
+         *         in the batch order.
+         */
+        virtual std::vector<data::movie_ref> add_bulk(
+            std::vector<std::unique_ptr<data::Movie>> movies);
+
         /**
          * \brief Remove a movie by title.
          * 
@@ -144,6 +164,154 @@ namespace core {
         std::vector<data::movie_ref> movies_slice(
             size_t offset, size_t count) const;
 
+        /**
+         * \brief Get a page of movies in a sorted order, using a cursor.
+         * 
+         * Sorted orders are maintained by the catalog (see \c sorted_index),
+         * so a page costs O(count) after the cursor lookup.
+         * 
+         * \param f      Field used to sort (see \c sorting::sort_by).
+         * \param ascending True for ascending order, false for descending.
+         * \param count  Maximum number of movies to return.
+         * \param after  Cursor: title of the last movie of the previous page,
+         *               or empty optional to start from the first movie.
+         * \return Vector of raw references to movies (non-owning). Empty if
+         *         the cursor movie does not exist.
+         */
+        std::vector<data::movie_ref> movies_sorted(
+            sorting::field f,
+            bool ascending,
+            size_t count,
+            const std::optional<std::string> &after = std::nullopt
+        ) const;
+
+        /**
+         * \brief  Get the index keeping movies sorted by a field.
+         * \param  f Field used to sort.
+         * \return Sorted index, maintained on add, remove and refresh.
+         */
+        const sorting::SortedIndex &sorted_index(sorting::field f) const;
+
+        /**
+         * \brief  Get the number of movies per category, year and director.
+         * 
+         * Counts are read from the bitmap indexes (see \c category_bitmap)
+         * and cached until the catalog changes (see \c version).
+         * 
+         * \return Counts of all movies of the catalog. They are shared with
+         *         the cache, but never modified: they stay valid (for the
+         *         previous version) after the catalog changes.
+         */
+        std::shared_ptr<const selection::Facets> facets() const;
+
+        /**
+         * \brief  Get the version of the catalog.
+         * \return A number increased by each add, remove or refresh.
+         */
+        uint64_t version() const;
+
+        /**
+         * \brief Select movies released in [value-delta; value+delta].
+         * 
+         * Same result as \c selection::select_by_year on \c all_movies, but
+         * the catalog keeps the years in a dense column, scanned with SIMD
+         * instructions (see \c scan::range).
+         * 
+         * \param value Year to match.
+         * \param delta Range around the year (default 0 for exact match).
+         * \return Vector of raw references to movies (non-owning), in the
+         *         catalog order.
+         */
+        std::vector<data::movie_ref> movies_by_year(
+            int value, int delta = 0) const;
+
+        /**
+         * \brief Select movies lasting [value-delta; value+delta] minutes.
+         * 
+         * Same as \c movies_by_year, for the durations.
+         * 
+         * \param value Duration in minutes to match.
+         * \param delta Allowed deviation from the target duration.
+         * \return Vector of raw references to movies (non-owning), in the
+         *         catalog order.
+         */
+        std::vector<data::movie_ref> movies_by_duration(
+            int value, int delta = 0) const;
+
+        /**
+         * \brief  Get the movies of a category, as a bitmap of slots.
+         * 
+         * Each movie gets a slot when added: the slot of a removed movie if
+         * any, else a new one after the others. Bitmaps can be combined with
+         * \c & and \c | then turned into movies with \c movies_in, until the
+         * catalog changes (a slot may then belong to another movie).
+         * 
+         * Example: the number of dramas from the 90s:
+         * @code
+         * (c.category_bitmap("Drame") & c.year_bitmap(1990, 1999)).cardinality();
+         * @endcode
+         * 
+         * \param  category Category to match.
+         * \return Slots of the movies (maintained on add, remove, refresh).
+         */
+        const Bitmap &category_bitmap(const std::string &category) const;
+
+        /**
+         * \brief  Get the movies of a director, as a bitmap of slots.
+         * \param  director Director to match.
+         * \return Slots of the movies (see \c category_bitmap).
+         */
+        const Bitmap &director_bitmap(const std::string &director) const;
+
+        /**
+         * \brief  Get the movies of an actor, as a bitmap of slots.
+         * \param  actor Actor to match (see \c data::Movie::actor_list).
+         * \return Slots of the movies (see \c category_bitmap).
+         */
+        const Bitmap &actor_bitmap(const std::string &actor) const;
+
+        /**
+         * \brief  Get the movies of an actor.
+         * 
+         * Same movies as \c selection::select_by_actor on \c all_movies, but
+         * read from the actor index: the cost depends on the number of
+         * movies of the actor, not on the size of the catalog.
+         * 
+         * \param  actor Actor to match (see \c data::Movie::actor_list).
+         * \param  offset Number of movies to skip.
+         * \param  count Maximum number of movies to return.
+         * \return Vector of raw references to movies (non-owning), in the
+         *         order of their slots (see \c movies_in).
+         */
+        std::vector<data::movie_ref> movies_by_actor(
+            const std::string &actor,
+            size_t offset = 0,
+            size_t count = SIZE_MAX
+        ) const;
+
+        /**
+         * \brief  Get the movies released in [min; max], as a bitmap of slots.
+         * \param  min First year.
+         * \param  max Last year.
+         * \return Slots of the movies (see \c category_bitmap).
+         */
+        Bitmap year_bitmap(int min, int max) const;
+
+        /**
+         * \brief  Get the movies of a bitmap of slots.
+         * \param  slots Bitmap of slots (see \c category_bitmap).
+         * \param  offset Number of movies to skip.
+         * \param  count Maximum number of movies to return.
+         * \return Vector of raw references to movies (non-owning), in the
+         *         order of their slots (the catalog order, unless slots of
+         *         removed movies have been reused).
+         */
+        std::vector<data::movie_ref> movies_in(
+            const Bitmap &slots,
+            size_t offset = 0,
+            size_t count = SIZE_MAX
+        ) const;
+
         /**
          * \brief  Get a movie by title.
          * \param  title Title of the movie.
@@ -153,6 +321,15 @@ namespace core {
         std::optional<data::movie_ref> get_movie(
             const std::string &title) const;
 
+        /**
+         * \brief Notify the catalog that a movie has been edited.
+         * 
+         * Sorted orders depending on the movie fields are updated.
+         * 
+         * \param title Title of the edited movie.
+         */
+        void refresh(const std::string &title);
+
         /**
          * \brief  Check if a movie exists.
          * \param  title Title of the movie.
@@ -178,9 +355,79 @@ namespace core {
          */
         std::optional<data::movie_ref> get_movie(const size_t index) const;
 
+        /**
+         * \brief Called by \c save once the CSV file is written.
+         * \param filename Path to the CSV file.
+         * \param offsets Byte offset of the row of each movie, in the order
+         *        of \c all_movies.
+         * \param title_column Index of the "title" column.
+         * \param synopsis_column Index of the "synopsis" column.
+         */
+        virtual void saved(const std::string &filename,
+                           const std::vector<std::streamoff> &offsets,
+                           size_t title_column, size_t synopsis_column) const;
+
     private:
         /// list of all movies in the catalog
         std::vector<std::unique_ptr<data::Movie>> _data;
+
+        /// Map from title to position in \c _data.
+        std::unordered_map<std::string, size_t> _positions;
+
+        /// Movie and indexed values of a slot (see \c category_bitmap).
+        struct slot {
+            data::Movie *movie; ///< Null once the movie is removed.
+            std::string category, director;
+            int year;
+            std::vector<std::string> actors;
+        };
+
+        /// Give a slot to a movie (reusing a free one if any) and index it.
+        uint32_t add_slot(data::Movie *m);
+
+        /// Add a slot to the bitmap indexes, with the current movie values.
+        void index_slot(uint32_t s);
+
+        /// Remove a slot from the bitmap indexes.
+        void unindex_slot(uint32_t s);
+
+        /// Increased by each change (see \c version).
+        uint64_t _version = 0;
+
+        /// Cached facets, valid while \c _facets_version is \c _version.
+        mutable std::shared_ptr<const selection::Facets> _facets;
+        mutable uint64_t _facets_version = 0;
+
+        /// Dense columns: year and duration of each movie of \c _data.
+        std::vector<int> _years, _durations;
+
+        /// Movies of \c _data at the given positions.
+        std::vector<data::movie_ref> movies_at(
+            const std::vector<uint32_t> &positions) const;
+
+        /// Slot of each movie of \c _data.
+        std::vector<uint32_t> _data_slots;
+
+        /// All slots, used or free.
+        std::vector<slot> _slots;
+
+        /// Slots of removed movies, reused by the next additions.
+        std::vector<uint32_t> _free_slots;
+
+        /// Bitmap indexes: slots of the movies having a value.
+        std::unordered_map<std::string, Bitmap> _category_bitmaps;
+        std::unordered_map<std::string, Bitmap> _director_bitmaps;
+        std::map<int, Bitmap> _year_bitmaps;
+        std::unordered_map<std::string, Bitmap> _actor_bitmaps;
+
+        /// Sorted indexes, one per field (see \c sorting::field).
+        std::array<sorting::SortedIndex, 5> _indexes = {{
+            sorting::SortedIndex(sorting::TITLE),
+            sorting::SortedIndex(sorting::YEAR),
+            sorting::SortedIndex(sorting::CATEGORY),
+            sorting::SortedIndex(sorting::DIRECTOR),
+            sorting::SortedIndex(sorting::DURATION)
+        }};
     };
 
 
@@ -220,6 +467,14 @@ namespace core {
          */
         void add(std::unique_ptr<data::Movie> m) override;
 
+        /**
+         * \brief Add several movies to the catalog at once.
+         * \param movies Movies to add.
+         * \return References to the movies actually added.
+         */
+        std::vector<data::movie_ref> add_bulk(
+            std::vector<std::unique_ptr<data::Movie>> movies) override;
+
         /**
          * \brief Remove a movie and its cached synopsis.
          * \param title Title of the movie.
@@ -244,6 +499,12 @@ namespace core {
             const std::string &title);
 
     private:
+        /**
+         * \brief Wrap the synopsis provider of a movie to use the cache.
+         * \param m Movie to update.
+         */
+        void use_cache(data::Movie &m);
+
         /// Map from title to cached synopsis.
         std::unordered_map<std::string, std::string> _cache;
 
@@ -286,6 +547,14 @@ namespace core {
          */
         void add(std::unique_ptr<data::Movie> m) override;
 
+        /**
+         * \brief Add several movies to the catalog at once.
+         * \param movies Movies to add.
+         * \return References to the movies actually added.
+         */
+        std::vector<data::movie_ref> add_bulk(
+            std::vector<std::unique_ptr<data::Movie>> movies) override;
+
         /**
          * \brief  Check if a movie synopsis is cached (page-based).
          * \param  title Title of the movie.
@@ -306,6 +575,12 @@ namespace core {
             const std::string& title);
 
     private:
+        /**
+         * \brief Wrap the synopsis provider of a movie to use the cache.
+         * \param m Movie to update.
+         */
+        void use_cache(data::Movie &m);
+
         /**
          * \brief  Get a cached page by index.
          * 
@@ -340,6 +615,52 @@ namespace core {
         const size_t _cache_size;
     };
 
+
+    // --------------------------------------------------------------------
+
+    /**
+     * \brief Catalog loading synopses lazily from their CSV row offset.
+     *
+     * At load time, the byte offset of each movie row is kept instead of
+     * its synopsis, so the resident memory does not depend on the synopses
+     * size. A synopsis is read on first access by seeking directly to its
+     * row (no full scan of the file), then kept in the LRU cache of
+     * \c CachedCatalog until it gets evicted.
+     *
+     * \note Only synopses are lazy: the other fields, and the indexes built
+     *       from them, stay in memory (most of the footprint of a catalog,
+     *       see bench_catalog).
+     */
+    class LazyCatalog: public CachedCatalog {
+    public:
+        /**
+         * \brief Construct a lazy catalog from a CSV file.
+         *
+         * \param filename Path to the CSV file.
+         * \param cache_size Maximum number of synopses in cache.
+         *
+         * \throw std::runtime_error If the CSV file cannot be opened.
+         * \throw std::runtime_error If the CSV file is invalid or if
+         *        one or more columns are missing.
+         *
+         * \note This constructor uses \c IndexedCSVSynopsisProvider
+         */
+        LazyCatalog(const std::string &filename, size_t cache_size);
+
+    protected:
+        /**
+         * \brief Update the row offsets of the movies read from a file that
+         *        has been rewritten by \c save.
+         * \param filename Path to the CSV file.
+         * \param offsets Byte offset of the row of each movie.
+         * \param title_column Index of the "title" column.
+         * \param synopsis_column Index of the "synopsis" column.
+         */
+        void saved(const std::string &filename,
+                   const std::vector<std::streamoff> &offsets,
+                   size_t title_column, size_t synopsis_column) const override;
+    };
+
 } // namespace core
 
 #endif // CATALOG_H
@@ -0,0 +1,151 @@
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "movie.h"
+
+/**
+ * \file completion.h
+ * \brief Defines an in-memory prefix index for search-as-you-type.
+ */
+
+namespace core {
+
+    /**
+     * \class Completion
+     * \brief Suggests titles, directors and actors starting with a prefix,
+     *        most popular first.
+     *
+     * Each distinct title, director or actor is an entry, weighted by the
+     * number of movies it appears in. Entries are kept in a sorted array of
+     * normalized keys (see \c slug), so the entries starting with a prefix
+     * are a range found by binary search. A segment tree gives the heaviest
+     * entry of any range, so the \p k best suggestions are extracted in
+     * O(k log n) whatever the size of the range: no query parsing nor
+     * stemming, for a request per keystroke.
+     *
+     * Weight changes update the tree in place. New or removed entries move
+     * the others, so they are merged into the array, and the tree rebuilt,
+     * by the next \c suggest (in linear time, without sorting it again).
+     */
+    class Completion {
+    public:
+        /**
+         * \enum field
+         * \brief Field of a movie an entry comes from.
+         */
+        enum field { TITLE, DIRECTOR, ACTOR };
+
+        /**
+         * \struct Suggestion
+         * \brief A suggested completion.
+         */
+        struct Suggestion {
+            std::string text; ///< Text, as written in the first movie.
+            field type;       ///< Field of the movies containing it.
+            size_t weight;    ///< Number of movies containing it.
+        };
+
+        /// Construct an empty index.
+        Completion() = default;
+
+        /**
+         * \brief Add the title, director and actors of a movie.
+         * 
+         * The values added for each movie are kept, so adding a movie
+         * again after it changed replaces its previous values.
+         * 
+         * \param m Movie to add.
+         */
+        void add(const data::Movie &m);
+
+        /**
+         * \brief Remove the values added for a movie.
+         * \param title Title of the movie (nothing happens if unknown).
+         */
+        void remove(const std::string &title);
+
+        /// Remove all entries.
+        void clear();
+
+        /// Get the number of entries (distinct values of each field).
+        size_t size() const;
+
+        /**
+         * \brief  Get the best completions of a prefix.
+         * \param  prefix Beginning of a title, director or actor, compared
+         *                without case nor accents.
+         * \param  k Maximum number of suggestions.
+         * \return Suggestions starting with \p prefix, by decreasing weight
+         *         then alphabetical order.
+         */
+        std::vector<Suggestion> suggest(const std::string &prefix, size_t k) const;
+
+    private:
+        struct entry {
+            std::string key;  ///< Normalized text.
+            std::string text;
+            field type;
+            size_t weight;
+            uint32_t pos;     ///< Position in \c _sorted (or \c NONE).
+        };
+
+        /// Position of the entries not in \c _sorted yet.
+        static const uint32_t NONE = UINT32_MAX;
+
+        /// Add 1 (or -1) to the weight of an entry, creating it if needed.
+        void change(const std::string &text, field type, int delta);
+
+        /// Compare the keys then the fields of two entries.
+        bool less(uint32_t a, uint32_t b) const;
+
+        /// Merge the new entries into \c _sorted, drop the removed ones
+        /// (weight 0) and rebuild the segment tree.
+        void rebuild() const;
+
+        /// Update the segment tree after a weight change at a position.
+        void update_tree(size_t pos) const;
+
+        /// Position of the heaviest entry in [lo, hi), or hi if empty.
+        size_t heaviest(size_t lo, size_t hi) const;
+
+        /// Position of the heaviest of two entries (the first one if equal),
+        /// positions out of \c _sorted being empty.
+        size_t best_of(size_t a, size_t b) const;
+
+        /// Entries, by id (their place never changes).
+        mutable std::vector<entry> _entries;
+
+        /// Id of each entry, by field then key. Removed entries stay until
+        /// the next rebuild, so a movie updated with the same values only
+        /// changes weights.
+        mutable std::unordered_map<std::string, uint32_t> _ids;
+
+        /// Number of removed entries not dropped yet.
+        mutable size_t _nb_removed = 0;
+
+        /// Ids of removed entries, free to reuse.
+        mutable std::vector<uint32_t> _free;
+
+        /// Values added for each movie, by title.
+        std::unordered_map<
+            std::string, std::vector<std::pair<std::string, field>>> _movies;
+
+        /// Ids sorted by key then field (including removed entries and
+        /// excluding new ones until the next rebuild).
+        mutable std::vector<uint32_t> _sorted;
+
+        /// Ids of the entries created since the last rebuild.
+        mutable std::vector<uint32_t> _added;
+
+        /// Segment tree: position of the heaviest entry of each node.
+        mutable std::vector<uint32_t> _tree;
+    };
+
+} // namespace core
+
+#endif // COMPLETION_H
@@ -3,6 +3,7 @@
 
 #include "search.h"
 #include "catalog.h"
+#include "completion.h"
 
 /**
  * \file media_manager.h
@@ -11,6 +12,16 @@
 
 namespace core {
 
+    /**
+     * \struct SearchPage
+     * \brief A page of search results, with their movies.
+     */
+    struct SearchPage {
+        /// Movies and relevance scores, by descending relevance.
+        std::vector<std::pair<data::movie_ref, double>> results;
+        search::Matches matches; ///< Number of matches of the whole query.
+    };
+
     /**
      * \class MediaManager
      * \brief High-level manager for movie catalogs and search indexing.
@@ -28,7 +39,8 @@ namespace core {
         enum cache_type { 
             NO_CACHE,         ///< No caching.
             INDIVIDUAL_CACHE, ///< Individual LRU cache (per-synopsis).
-            PAGED_CACHE       ///< Paged LRU cache (pages of 10 movies).
+            PAGED_CACHE,      ///< Paged LRU cache (pages of 10 movies).
+            LAZY_CACHE        ///< Individual LRU cache, read by row offset.
         };
 
         /**
@@ -40,6 +52,8 @@ namespace core {
          *                     (see \c cache_type).
          * \param cache_size Cache capacity (number of entries or pages, 
          *                   depending on `catalog_type`).
+         * \note  An index written by another version of the indexer is
+         *        rebuilt from the catalog (see \c search::Indexer::outdated).
          */
         MediaManager(
             const std::filesystem::path &index_database,
@@ -86,6 +100,93 @@ namespace core {
          */
         std::vector<data::movie_ref> movies(size_t offset, size_t count) const;
 
+        /**
+         * \brief Get a page of the movies matching a query.
+         * 
+         * Example: the first 24 comedies lasting 80 to 100 minutes:
+         * @code
+         * mm.movies(selection::Query().category("Comédie").duration(90, 10),
+         *           0, 24);
+         * @endcode
+         * 
+         * \param query Selection criteria.
+         * \param offset Number of matching movies to skip.
+         * \param count Maximum number of movies to return.
+         * \return A vector of references to the selected movies, in the
+         *         catalog order.
+         */
+        std::vector<data::movie_ref> movies(
+            const selection::Query &query,
+            size_t offset,
+            size_t count
+        ) const;
+
+        /**
+         * \brief Get a page of the movies of an actor.
+         * \param actor Actor name (see \c data::Movie::actor_list).
+         * \param offset Number of movies to skip.
+         * \param count Maximum number of movies to return.
+         * \return A vector of references to the selected movies, in the
+         *         order of the catalog actor index (see
+         *         \c BasicCatalog::movies_in).
+         */
+        std::vector<data::movie_ref> movies_by_actor(
+            const std::string &actor,
+            size_t offset,
+            size_t count
+        ) const;
+
+        /**
+         * \brief Get a page of movies in a sorted order, using a cursor.
+         * 
+         * Example: the 24 movies following "Germinal" by descending year:
+         * @code
+         * mm.movies_sorted(sorting::YEAR, false, 24, "Germinal");
+         * @endcode
+         * 
+         * \param f Field used to sort.
+         * \param ascending True for ascending order, false for descending.
+         * \param count Maximum number of movies to return.
+         * \param after Title of the last movie of the previous page, or empty
+         *              optional to start from the first movie.
+         * \return A vector of references to the selected movies.
+         */
+        std::vector<data::movie_ref> movies_sorted(
+            sorting::field f,
+            bool ascending,
+            size_t count,
+            const std::optional<std::string> &after = std::nullopt
+        ) const;
+
+        /**
+         * \brief  Get the number of movies per category, year and director.
+         * \return Counts of all movies, cached until the catalog changes
+         *         (see \c BasicCatalog::facets).
+         */
+        std::shared_ptr<const selection::Facets> facets() const;
+
+        /**
+         * \brief Suggest completions of a prefix, for search-as-you-type.
+         * 
+         * Read from an in-memory index of the titles, directors and actors
+         * (see \c Completion), kept in sync with the catalog: the query
+         * parser and the search index are not used.
+         * 
+         * \param prefix Beginning of a title, director or actor (case and
+         *               accents are ignored).
+         * \param k Maximum number of suggestions.
+         * \return Suggestions, the most frequent in the catalog first.
+         */
+        std::vector<Completion::Suggestion> suggest(
+            const std::string &prefix, size_t k = 10) const;
+
+        /**
+         * \brief  Get the statistics of the search index.
+         * \return Statistics, cached until the index changes (see
+         *         \c search::Indexer::stats).
+         */
+        search::Stats index_stats() const;
+
         /**
          * \brief Get the number of movies in the catalog.
          * \return Total number of movies.
@@ -97,10 +198,21 @@ namespace core {
 
         /**
          * \brief Add a movie to the catalog and index.
-         * \param m Movie to add (ownership transferred).
+         * \param m Movie to add (ownership transferred), ignored if a movie
+         *          with the same title is already in the catalog.
          */
         void add(std::unique_ptr<data::Movie> m);
 
+        /**
+         * \brief Add several movies to the catalog and index at once.
+         * 
+         * Movies already in the catalog (or duplicated in the batch) are
+         * ignored. The others are indexed in a single transaction.
+         * 
+         * \param movies Movies to add (ownership transferred).
+         */
+        void add_bulk(std::vector<std::unique_ptr<data::Movie>> movies);
+
         /**
          * \brief Remove a movie from the catalog and index.
          * \param title Title of the movie to remove.
@@ -116,8 +228,30 @@ namespace core {
 
         /**
          * \brief Reindex all movies in the catalog.
+         * 
+         * Movies are indexed in batches, each committed in its own
+         * transaction (see \c search::Indexer::reindex_all).
+         * 
+         * Example: print the progress every 1000 movies:
+         * @code
+         * mm.reindex_all([](size_t done, size_t total) {
+         *     std::cout << done << "/" << total << std::endl;
+         * });
+         * @endcode
+         * 
+         * A nightly consistency pass only needs the \c search::INCREMENTAL
+         * mode: unchanged movies are neither indexed nor refreshed.
+         * 
+         * \param on_progress Called after each committed batch (optional).
+         * \param batch_size Number of movies per transaction.
+         * \param mode Reindex all movies (\c search::FULL) or only the
+         *             changed ones (\c search::INCREMENTAL).
          */
-        void reindex_all();
+        void reindex_all(
+            const search::Indexer::progress_callback &on_progress = nullptr,
+            size_t batch_size = search::Indexer::DEFAULT_BATCH_SIZE,
+            search::reindex_mode mode = search::FULL
+        );
 
         /**
          * \brief Flush pending data and ensure consistency.
@@ -135,9 +269,28 @@ namespace core {
         std::vector<std::pair<data::movie_ref, double>> search(
             std::string query, size_t max_result = 10) const;
 
+        /**
+         * \brief Get a page of the results of a search query.
+         * \param query Search string (with field prefixes and ranges, see
+         *              \c search::Indexer::search).
+         * \param offset Rank of the first result (0 for the first page).
+         * \param count Maximum number of results in the page.
+         * \param sort Order of the results (by relevance by default).
+         * \return The movies of the page, in the \p sort order, and the
+         *         estimated number of matches of the query (see
+         *         \c search::Indexer::search_page).
+         */
+        SearchPage search_page(
+            std::string query,
+            size_t offset,
+            size_t count,
+            search::order sort = search::RELEVANCE
+        ) const;
+
     private:
         BasicCatalog *_movies;    ///< Catalog of movies (may be cached).
         search::Indexer *_index;  ///< Full-text search index.
+        Completion _completion;   ///< Prefix index for \c suggest.
 
         /// CSV file associated with the catalog.
         std::filesystem::path _csv_file;
@@ -2,9 +2,11 @@
 #define FILM_H
 
 #include <string>
+#include <vector>
 #include <filesystem>
 #include <optional>
 #include <functional>
+#include <cstdint>
 
 #include "cover.h"
 
@@ -111,11 +113,72 @@ namespace core::data {
          * \note Overwrite all the CSV file
          */
         virtual void set_synopsis(const std::string &synopsis) override;
-    private:
+    protected:
         const std::string _title;      ///< Movie title used for lookup
         const std::string _csv_file;   ///< Path to the CSV file
     };
 
+    /**
+     * \brief Provides a synopsis stored in a CSV file at a known offset.
+     *
+     * The synopsis is read by seeking directly to the movie row, instead of
+     * scanning the whole file. If the row found at this offset does not match
+     * the movie title (e.g. the file has been rewritten), it falls back to
+     * the \c CSVFileSynopsisProvider lookup.
+     */
+    class IndexedCSVSynopsisProvider: public CSVFileSynopsisProvider {
+    public:
+        /**
+         * \brief Construct with the movie title, CSV filename and row offset.
+         * \param movie_title Title of the movie to look up.
+         * \param csv_filename Path to the CSV file.
+         * \param offset Byte offset of the movie row in the CSV file.
+         * \param title_column Index of the "title" column.
+         * \param synopsis_column Index of the "synopsis" column.
+         */
+        IndexedCSVSynopsisProvider(
+            const std::string &movie_title,
+            const std::string &csv_filename,
+            std::streamoff offset,
+            size_t title_column,
+            size_t synopsis_column
+        );
+
+        /**
+         * \brief Retrieve the synopsis from the CSV file.
+         * \return Synopsis string from the CSV file.
+         *
+         * \throws std::runtime_error If the CSV file cannot be opened
+         *         for reading.
+         */
+        virtual std::string get_synopsis() const override;
+
+        /**
+         * \brief Check if the synopsis is read from a given CSV file.
+         * \param csv_filename Path to a CSV file.
+         * \return True if \p csv_filename is the file of this provider.
+         */
+        bool reads(const std::string &csv_filename) const;
+
+        /// Get the byte offset of the movie row.
+        std::streamoff offset() const;
+
+        /**
+         * \brief Change the location of the movie row (e.g. after the file
+         *        has been rewritten).
+         * \param offset Byte offset of the movie row in the CSV file.
+         * \param title_column Index of the "title" column.
+         * \param synopsis_column Index of the "synopsis" column.
+         */
+        void relocate(std::streamoff offset, size_t title_column,
+                      size_t synopsis_column);
+
+    private:
+        std::streamoff _offset;  ///< Offset of the movie row
+        size_t _title_column;    ///< Index of the title column
+        size_t _synopsis_column; ///< Index of the synopsis column
+    };
+
     /*---------------------------------------------------------
                             Movie class
       ---------------------------------------------------------*/
@@ -191,7 +254,7 @@ namespace core::data {
          * \brief Get the title of the movie.
          * \return Movie title.
          */
-        std::string title() const;
+        const std::string &title() const;
 
         /**
          * \brief Get the release year of the movie.
@@ -203,25 +266,55 @@ namespace core::data {
          * \brief Get the category/genre of the movie.
          * \return Category name.
          */
-        std::string category() const;
+        const std::string &category() const;
 
         /**
          * \brief Get the producer of the movie.
          * \return Producer name.
          */
-        std::string producer() const;
+        const std::string &producer() const;
 
         /**
          * \brief Get the director of the movie.
          * \return Director name.
          */
-        std::string director() const;
+        const std::string &director() const;
 
         /**
          * \brief Get the actors of the movie.
          * \return Actors list in string format.
          */
-        std::string actors() const;
+        const std::string &actors() const;
+
+        /**
+         * \brief Get the actors of the movie, one by one.
+         *
+         * The actors string is split on commas, and each name is trimmed
+         * (e.g. "Raimu, Pierre Fresnay" gives "Raimu" and "Pierre Fresnay").
+         * The list is parsed once, when the actors are set.
+         *
+         * \return Actors names, in the string order, without empty names.
+         */
+        const std::vector<std::string> &actor_list() const;
+
+        /**
+         * \brief Get the normalized title, to match titles regardless of
+         *        case and accents (e.g. "Amélie" gives "amelie").
+         * \return Title converted by \c core::slug, computed when set.
+         */
+        const std::string &title_key() const;
+
+        /**
+         * \brief Get the normalized category (see \c title_key).
+         * \return Category converted by \c core::slug, computed when set.
+         */
+        const std::string &category_key() const;
+
+        /**
+         * \brief Get the normalized director (see \c title_key).
+         * \return Director converted by \c core::slug, computed when set.
+         */
+        const std::string &director_key() const;
 
         /**
          * \brief Get the duration of the movie in minutes.
@@ -237,6 +330,22 @@ namespace core::data {
          */
         std::string synopsis() const;
 
+        /**
+         * \brief Get a hash of the synopsis (see \c core::fnv1a), to detect
+         *        changes without reading it again.
+         *
+         * The hash is kept from the first read of the synopsis (or given by
+         * \c set_synopsis_hash, e.g. when a catalog is loaded), and updated
+         * by \c set_synopsis.
+         *
+         * \return Hash of the synopsis.
+         * \throws std::runtime_error If the synopsis has to be read and an
+         *         error occurs during reading.
+         * \note Changes made to the synopsis source outside of this movie
+         *       (e.g. another program editing the CSV file) are not seen.
+         */
+        uint64_t synopsis_hash() const;
+
         /**
          * \brief Get duration formatted as "Hh Mmin".
          * \return Human-readable duration string.
@@ -305,6 +414,13 @@ namespace core::data {
          */
         void set_synopsis(const std::string &synopsis);
 
+        /**
+         * \brief Set the hash of the synopsis, when it has already been read
+         *        elsewhere (e.g. while loading the catalog).
+         * \param hash Hash of the current synopsis (see \c synopsis_hash).
+         */
+        void set_synopsis_hash(uint64_t hash);
+
         /**
          * \brief Set the cover of the movie.
          * \param cover New cover object.
@@ -333,6 +449,8 @@ namespace core::data {
          *
          * \note The current provider is moved into \p chg_fct. The returned provider
          * replaces it. So, the given \c chg_fct function MUST never return nullptr.
+         * \note The synopsis hash is kept: the new provider is expected to give
+         * the same synopsis (e.g. a cache wrapping the current provider).
          */
         void change_synopsis_provider(std::function<
             std::unique_ptr<data::SynopsisProvider>(
@@ -379,11 +497,16 @@ namespace core::data {
         std::string _producer;             ///< Producer name
         std::string _director;             ///< Director name
         std::string _actors;               ///< Actors list in string format
+        std::vector<std::string> _actor_list; ///< Parsed actors list
         int _duration;                     ///< Duration in minutes
         /// Custom synopsis provider
         std::unique_ptr<SynopsisProvider> _synopsis;
         Cover _cover;                      ///< Associated cover
         std::filesystem::path _video_file; ///< Video file path
+        /// Normalized title, category and director (see \c title_key)
+        std::string _title_key, _category_key, _director_key;
+        /// Hash of the synopsis, once known (see \c synopsis_hash)
+        mutable std::optional<uint64_t> _synopsis_hash;
     };
 
     /// Alias for a reference to a Movie object.
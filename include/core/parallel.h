@@ -0,0 +1,72 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * \file parallel.h
+ * \brief Settings and helpers to split work on large catalogs across threads.
+ *
+ * Sorting and selection functions switch to their parallel versions when
+ * the number of movies reaches a threshold and several threads are allowed.
+ * By default, one thread per hardware thread is allowed: single core boards
+ * always use the sequential versions.
+ */
+
+namespace core::parallel {
+
+    /**
+     * \brief Set the maximum number of threads used by parallel algorithms.
+     * \param n Number of threads (0, the default, means one per hardware
+     *          thread; 1 disables parallel algorithms).
+     */
+    void set_nb_threads(size_t n);
+
+    /**
+     * \brief Get the maximum number of threads used by parallel algorithms.
+     * \return Number of threads (at least 1).
+     */
+    size_t nb_threads();
+
+    /**
+     * \brief Set the number of movies from which parallel algorithms are used.
+     * \param n Minimum number of movies.
+     */
+    void set_threshold(size_t n);
+
+    /**
+     * \brief Get the number of movies from which parallel algorithms are used.
+     * \return Minimum number of movies.
+     */
+    size_t threshold();
+
+    /**
+     * \brief Check if a parallel algorithm should be used.
+     * \param n Number of movies to process.
+     * \return True if \p n reaches the threshold and several threads are
+     *         allowed.
+     */
+    bool enabled(size_t n);
+
+    /**
+     * \brief Split [0; n[ into contiguous chunks and process each of them on
+     *        its own thread.
+     *
+     * \param n Number of elements to process.
+     * \param nb_chunks Number of chunks (and threads), at least 1.
+     * \param f Function called as f(chunk, begin, end) for each chunk.
+     *
+     * \note Returns once every chunk has been processed. Exceptions thrown
+     *       by \p f are rethrown (the first one only). If a thread cannot
+     *       be started, its chunk runs on the calling thread.
+     */
+    void for_chunks(
+        size_t n,
+        size_t nb_chunks,
+        const std::function<void(size_t, size_t, size_t)> &f
+    );
+
+} // namespace core::parallel
+
+#endif // PARALLEL_H
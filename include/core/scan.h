@@ -0,0 +1,69 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \file scan.h
+ * \brief Vectorized scans over dense integer columns (e.g. years or
+ *        durations of all movies of a catalog).
+ *
+ * Kernels use SIMD instructions (SSE2 or AVX2 on x86, NEON on ARM) when
+ * the running CPU supports them, and a scalar loop otherwise. The kernel
+ * is chosen at runtime, so the same binary runs on any of these CPUs.
+ */
+
+namespace core::scan {
+
+    /**
+     * \enum kernel
+     * \brief Implementations of the scans.
+     */
+    enum kernel {
+        SCALAR, ///< Plain loop, always available.
+        SSE2,   ///< 4 integers at a time (x86).
+        AVX2,   ///< 8 integers at a time (x86).
+        NEON    ///< 4 integers at a time (ARM).
+    };
+
+    /**
+     * \brief  Check if a kernel can run on this CPU (and has been compiled).
+     * \param  k Kernel to check.
+     * \return True if \p k is supported.
+     */
+    bool supported(kernel k);
+
+    /**
+     * \brief  Get the fastest kernel supported by this CPU.
+     * \return Kernel used by \c range.
+     */
+    kernel best_kernel();
+
+    /**
+     * \brief Find the values within an interval.
+     * \param values Dense array of values.
+     * \param n Number of values.
+     * \param min Minimum accepted value.
+     * \param max Maximum accepted value.
+     * \return Indexes of the values in [min; max], in increasing order.
+     */
+    std::vector<uint32_t> range(const int *values, size_t n, int min, int max);
+
+    /**
+     * \brief Find the values within an interval, using a given kernel.
+     * \param k Kernel to use (must be supported, see \c supported).
+     * \param values Dense array of values.
+     * \param n Number of values.
+     * \param min Minimum accepted value.
+     * \param max Maximum accepted value.
+     * \return Indexes of the values in [min; max], in increasing order.
+     * \throw std::invalid_argument If \p k is not supported.
+     */
+    std::vector<uint32_t> range(
+        kernel k, const int *values, size_t n, int min, int max);
+
+} // namespace core::scan
+
+#endif // SCAN_H
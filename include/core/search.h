@@ -3,6 +3,14 @@
 
 #include <string>
 #include <vector>
+#include <functional>
+#include <optional>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <xapian.h>
 
 #include "movie.h"
@@ -14,6 +22,63 @@
 
 namespace core::search {
 
+    /**
+     * \struct Stats
+     * \brief Statistics of a search index.
+     */
+    struct Stats {
+        size_t nb_terms = 0;     ///< Number of distinct terms.
+        size_t nb_movies = 0;    ///< Number of indexed movies.
+        double avg_length = 0;   ///< Average number of terms per movie.
+        uintmax_t disk_size = 0; ///< Size of the database files, in bytes.
+    };
+
+    /**
+     * \enum order
+     * \brief Order of search results.
+     * 
+     * Results with the same year or duration are sorted by relevance.
+     */
+    enum order {
+        RELEVANCE,     ///< Descending relevance.
+        YEAR_ASC,      ///< Ascending year.
+        YEAR_DESC,     ///< Descending year.
+        DURATION_ASC,  ///< Ascending duration.
+        DURATION_DESC  ///< Descending duration.
+    };
+
+    /**
+     * \enum reindex_mode
+     * \brief Movies written by \c Indexer::reindex_all.
+     */
+    enum reindex_mode {
+        FULL,        ///< All movies.
+        INCREMENTAL  ///< Movies whose indexed fields changed, or new ones.
+    };
+
+    /**
+     * \struct Matches
+     * \brief Number of documents matching a query, as estimated by Xapian.
+     * 
+     * Xapian stops as soon as it has the requested results, so the exact
+     * number of matches is usually unknown: it lies between the bounds.
+     */
+    struct Matches {
+        size_t estimated = 0;   ///< Estimated number of matches.
+        size_t lower_bound = 0; ///< At least this number of matches.
+        size_t upper_bound = 0; ///< At most this number of matches.
+    };
+
+    /**
+     * \struct Page
+     * \brief A page of search results.
+     */
+    struct Page {
+        /// Stored data (movie title) and relevance score of each result.
+        std::vector<std::pair<std::string, double>> results;
+        Matches matches; ///< Number of matches of the whole query.
+    };
+
     /**
      * \class Indexer
      * \brief A simple indexer for storing and searching Movie data using Xapian.
@@ -21,17 +86,44 @@ namespace core::search {
      * This class wraps a Xapian writable database and a TermGenerator to provide
      * basic indexing operations such as adding, editing, and removing movies.
      * It also allows retrieving some statistics about the database.
+     * 
+     * All methods may be called from several threads. Searches use a pool of
+     * read-only handles, reopened after each commit, so they run in
+     * parallel with each other and with indexing. Changes not committed
+     * yet (see \c flush) are committed by the next search, unless the
+     * writable database is busy: the search then returns the last
+     * committed documents, without waiting.
      */
     class Indexer {
     public:
+        /**
+         * \brief Callback reporting the progress of a long operation.
+         * 
+         * Called with the number of movies done and the total number of
+         * movies.
+         */
+        using progress_callback = std::function<void(size_t, size_t)>;
+
+        /// Default number of movies indexed per transaction by \c reindex_all.
+        static const size_t DEFAULT_BATCH_SIZE = 1000;
+
+        /// Default number of results lists kept by \c search.
+        static const size_t DEFAULT_CACHE_SIZE = 256;
+
         /**
          * \brief Constructs an Indexer and opens the database at the given path.
          * 
          * \param db_path Path to the Xapian writable database.
          * \param lang Language code (e.g., "en", "fr") used for text stemming 
          *             and analysis. Refer to the xapian's doc.
+         * \param cache_size Maximum number of results lists cached by
+         *             \c search (0 to disable the cache).
          */
-        Indexer(const std::string &db_path, const std::string &lang);
+        Indexer(
+            const std::string &db_path,
+            const std::string &lang,
+            size_t cache_size = DEFAULT_CACHE_SIZE
+        );
 
         /**
          * \brief Destructor for Indexer.
@@ -44,6 +136,7 @@ namespace core::search {
          * \brief Returns the total number of indexed terms in the database.
          * 
          * \return Number of terms currently indexed.
+         * \note  Read from the cached statistics (see \c stats).
          */
         size_t nb_terms();
 
@@ -54,6 +147,51 @@ namespace core::search {
          */
         size_t nb_movies();
 
+        /**
+         * \brief Get the statistics of the database.
+         * 
+         * Counting the terms requires to walk the whole vocabulary, so the
+         * statistics are computed once on a read-only handle (without
+         * blocking indexing), then cached until the next commit: reading
+         * them repeatedly (e.g. by a metrics endpoint) costs nothing while
+         * the index does not change.
+         * 
+         * \return Statistics of the committed documents. Pending changes are
+         *         committed first, as by \c search.
+         */
+        Stats stats() const;
+
+        /**
+         * \brief  Get the generation of the index.
+         * \return A number increased by each change or commit (add, remove,
+         *         flush, clear, reindex...).
+         */
+        uint64_t generation() const;
+
+        /**
+         * \brief Check if the documents were written by another version of
+         *        the indexer (e.g. with other unique ids).
+         * 
+         * Such documents are not found by \c edit nor \c remove, so the
+         * database needs a full \c reindex_all: until then, an
+         * \c INCREMENTAL reindex writes all movies, as a \c FULL one.
+         * 
+         * \return True if a full reindex is needed.
+         */
+        bool outdated() const;
+
+        /**
+         * \brief Set the number of threads preparing documents in
+         *        \c add_bulk and \c reindex_all.
+         * 
+         * By default, documents are prepared on \c parallel::nb_threads()
+         * threads (one per hardware thread).
+         * 
+         * \param n Number of threads (0, the default, for
+         *          \c parallel::nb_threads(); 1 for the calling thread only).
+         */
+        void set_nb_workers(size_t n);
+
         /**
          * \brief Adds a new movie to the database.
          * 
@@ -61,6 +199,62 @@ namespace core::search {
          */
         void add(const data::movie_ref &m);
 
+        /**
+         * \brief Adds several movies to the database at once.
+         * 
+         * All movies are indexed inside a single transaction, which is
+         * committed at the end. Terms may be generated on several threads
+         * (see \c reindex_all).
+         * 
+         * \param movies References to the Movie objects to index.
+         */
+        void add_bulk(const std::vector<data::movie_ref> &movies);
+
+        /**
+         * \brief Replace the content of the database by the given movies.
+         * 
+         * Movies are indexed in batches of \p batch_size, each one inside a
+         * transaction committed at its end: the cost of the commits is
+         * spread over many documents, and the memory used by pending
+         * changes stays bounded. Documents are replaced in place (identified
+         * by their title), then the documents of movies which are not in
+         * \p movies anymore are removed, so the database stays searchable
+         * during the whole operation.
+         * 
+         * Unless disabled by \c set_nb_workers, and from 100 movies (or
+         * \c parallel::threshold() if lower), documents are prepared
+         * (tokenized and stemmed) on several threads, each owning a term
+         * generator, while the calling thread writes the previous batch.
+         * Fields are still read on the calling thread.
+         * 
+         * Each document stores a hash of the indexed fields of its movie.
+         * In \c INCREMENTAL mode, only the movies whose hash differs from
+         * the stored one (or which are not indexed yet) are tokenized and
+         * written. The synopsis is part of the hash through
+         * \c data::Movie::synopsis_hash, so on an unchanged library the pass
+         * reads the stored hashes and the metadata, but no synopsis.
+         * 
+         * \param movies All movies to index.
+         * \param batch_size Number of movies per transaction (at least 1).
+         * \param on_progress Called after each committed batch (optional),
+         *                    with the number of movies written so far and
+         *                    the number of movies to write. It is called
+         *                    without any lock held, so it may use the
+         *                    indexer (e.g. \c nb_movies).
+         * \param mode \c FULL to write all movies, \c INCREMENTAL to write
+         *             only the changed ones.
+         * \return The movies whose documents were written.
+         * 
+         * \note If an error occurs, the current batch is cancelled and the
+         *       exception is rethrown: previous batches stay committed.
+         */
+        std::vector<data::movie_ref> reindex_all(
+            const std::vector<data::movie_ref> &movies,
+            size_t batch_size = DEFAULT_BATCH_SIZE,
+            const progress_callback &on_progress = nullptr,
+            reindex_mode mode = FULL
+        );
+
         /**
          * \brief Edits an existing movie in the database.
          * 
@@ -86,6 +280,16 @@ namespace core::search {
 
         /**
          * \brief Erase all documents in the database
+         * 
+         * The database is replaced by a new empty database, which drops all
+         * documents and terms in one operation (pending changes are lost).
+         * The empty database is created next to it (\c <path>.new), then
+         * renamed into place.
+         * 
+         * \throw Xapian::Error If the empty database cannot be created (the
+         *        current database is left unchanged).
+         * \throw std::filesystem::filesystem_error If the directories cannot
+         *        be swapped (the previous database is reopened).
          */
         void clear();
 
@@ -100,6 +304,14 @@ namespace core::search {
          * 
          * The results are sorted by descending relevance (highest score first).
          * 
+         * Besides free text, the query may restrict words to a field with
+         * \c title:, \c category:, \c director:, \c producer: and
+         * \c actor: (e.g. \c director:pagnol, or a phrase with
+         * \c director:"Marcel Pagnol"), filter an exact year with
+         * \c year:1936, and filter ranges with \c year:1990..1999 or
+         * \c duration:..90 (bounds included, each one optional). Filters
+         * are applied by Xapian inside the match.
+         * 
          * Example usage:
          * @code
          * Indexer indexer("mydb", "en");
@@ -113,6 +325,11 @@ namespace core::search {
          * }
          * @endcode
          * 
+         * Results are kept in an LRU cache, keyed by the query (with runs of
+         * spaces collapsed) and \p max_results (see \c search_page), valid
+         * for the current \c generation only: a repeated query is answered
+         * without parsing it nor running Xapian, until the index changes.
+         * 
          * @param query_str The query string to search for.
          * @param max_results Maximum number of results to return (default: 10).
          * @return std::vector<std::pair<std::string, double>> 
@@ -122,18 +339,138 @@ namespace core::search {
         std::vector<std::pair<std::string, double>> 
             search(const std::string &query, size_t max_results = 10) const;
 
+        /**
+         * \brief Get a page of the results of a query.
+         * 
+         * Only ranks \p offset to \p offset + \p count are collected, so
+         * paging deep does not fetch the previous pages again. Pages are
+         * cached like the results of \c search (keyed by \p offset and
+         * \p sort too).
+         * 
+         * \param query The query string to search for (see \c search).
+         * \param offset Rank of the first result (0 for the first page).
+         * \param count Maximum number of results in the page.
+         * \param sort Order of the results, sorted inside the match from
+         *             the year and duration stored in value slots.
+         * \return The results, in the \p sort order, and the estimated
+         *         number of matches (to show "about N results").
+         */
+        Page search_page(
+            const std::string &query,
+            size_t offset,
+            size_t count,
+            order sort = RELEVANCE
+        ) const;
+
     private:
+        struct fields;
+        struct prepared;
+
+        /// Build the document of a movie with a term generator.
+        static prepared prepare(Xapian::TermGenerator &termgen,
+                                const fields &f);
+
+        /// Write documents by batches, one transaction per batch, while the
+        /// next batch is prepared on other threads (see \c parallel).
+        void write(
+            const std::vector<data::movie_ref> &movies,
+            size_t batch_size,
+            const progress_callback &on_progress
+        );
+
+        /// Get the hash of the fields stored in each document, by id.
+        std::unordered_map<std::string, std::string> stored_hashes() const;
+
+        /// Record a change (\p committed or not): increase the generation
+        /// (cached results are dropped by \c search, and cached statistics
+        /// by \c stats after a commit). Called with \c _db_mutex locked.
+        void changed(bool committed);
+
+        /// Commit pending changes, unless the writable database is busy.
+        void publish() const;
+
+        /// Search without cache.
+        Page search_uncached(
+            const std::string &query,
+            size_t offset,
+            size_t count,
+            order sort
+        ) const;
+
+        /// Read-only handle on the database, opened at a given commit.
+        struct reader {
+            Xapian::Database db;
+            uint64_t commit = 0; ///< Value of \c _commits when (re)opened.
+            uint64_t clears = 0; ///< Value of \c _clears when opened.
+        };
+
+        /// Take an idle reader (or open a new one), reopened if a commit
+        /// happened since it was last used.
+        std::unique_ptr<reader> acquire_reader() const;
+
+        /// Open a reader on the current database, from its path.
+        void open_reader(reader &r) const;
+
+        /// Reopen a reader at the last commit, or open it again if the
+        /// database has been replaced.
+        void reopen_reader(reader &r) const;
+
+        /// Give a reader back to the pool.
+        void release_reader(std::unique_ptr<reader> r) const;
+
+        /// Idle readers: one per concurrent search at most.
+        mutable std::vector<std::unique_ptr<reader>> _readers;
+        mutable std::mutex _pool_mutex;
+
+        /// Threads preparing documents (see \c set_nb_workers).
+        std::atomic<size_t> _nb_workers{0};
+
+        /// Number of commits, to know when readers must reopen.
+        mutable std::atomic<uint64_t> _commits{0};
+
+        /// Number of clears, to know when readers must be opened again.
+        std::atomic<uint64_t> _clears{0};
+
+        /// True while the writable database has uncommitted changes.
+        mutable std::atomic<bool> _dirty{false};
+
+        /// True until a full reindex if the documents have another version.
+        std::atomic<bool> _outdated{false};
+
+        /// Protects the writable database and the term generator.
+        mutable std::mutex _db_mutex;
+
+        /// Increased by each change (see \c generation).
+        std::atomic<uint64_t> _generation{0};
+
+        /// Cached results of \c search, most recently used first, valid for
+        /// \c _cache_generation.
+        using cached_results = std::pair<std::string, Page>;
+        mutable std::list<cached_results> _lru;
+        mutable std::unordered_map<
+            std::string, std::list<cached_results>::iterator> _cached;
+        mutable uint64_t _cache_generation = 0;
+        mutable std::mutex _cache_mutex;
+
+        /// Cached statistics (see \c stats), read at \c _stats_commit.
+        mutable std::optional<Stats> _stats;
+        mutable uint64_t _stats_commit = 0;
+        mutable std::mutex _stats_mutex;
+
         /// Path to the Xapian database
         const std::string _db_path;
 
-        /// Writable Xapian database
-        Xapian::WritableDatabase _db;
+        /// Writable Xapian database (committed by \c search, see above)
+        mutable Xapian::WritableDatabase _db;
 
         /// Term generator for indexing text
         Xapian::TermGenerator _termgen;
 
         /// Indexer lang
         const std::string _lang;
+
+        /// Maximum number of cached results lists.
+        const size_t _cache_size;
     };
         
 } // namespace core::search
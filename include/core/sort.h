@@ -2,6 +2,14 @@
 #define SORT_H
 
 #include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <tuple>
+#include <functional>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
 
 #include "movie.h"
 
@@ -24,6 +32,18 @@ namespace core {
         /// Type alias for a movie comparison function.
         using sort_func = bool(*)(const data::movie_ref, const data::movie_ref);
 
+        /**
+         * \enum field
+         * \brief Movie fields that can be used to sort.
+         */
+        enum field {
+            TITLE,    ///< See \c sort_by_title.
+            YEAR,     ///< See \c sort_by_year.
+            CATEGORY, ///< See \c sort_by_category.
+            DIRECTOR, ///< See \c sort_by_director.
+            DURATION  ///< See \c sort_by_duration.
+        };
+
         /**
          * \brief Sort a vector of movies using the provided comparison function.
          * \param movies Pointer to the vector of movies to sort.
@@ -31,6 +51,90 @@ namespace core {
          */
         void sort(std::vector<data::movie_ref> &, sort_func);
 
+        /**
+         * \brief Sort a vector of movies by a field, using extracted keys.
+         * 
+         * Gives the same order as \c sort with \c sort_by(f, ascending), 
+         * but the keys (field value and title tiebreak) are first copied 
+         * into a compact array which is sorted, then movies are permuted. 
+         * Comparisons mostly read fixed-size key prefixes instead of 
+         * calling the accessors of both movies.
+         * 
+         * \param movies Vector of movies to sort.
+         * \param f Field to sort by.
+         * \param ascending True for ascending order, false for descending.
+         */
+        void sort(std::vector<data::movie_ref> &movies, field f,
+                  bool ascending);
+
+        /**
+         * \brief Sort a vector of movies by a field, using a radix sort.
+         * 
+         * Gives the same order as \c sort with \c sort_by(f, ascending).
+         * Each movie is encoded as a fixed-width key (the year or duration 
+         * then the title prefix, or the text prefix), which is sorted byte
+         * by byte (MSD radix sort). Small buckets and movies with equal 
+         * keys are ordered by comparisons.
+         * 
+         * \c sort by field uses it automatically on large vectors.
+         * 
+         * \param movies Vector of movies to sort.
+         * \param f Field to sort by.
+         * \param ascending True for ascending order, false for descending.
+         */
+        void radix_sort(
+            std::vector<data::movie_ref> &movies,
+            field f,
+            bool ascending
+        );
+
+        /**
+         * \brief Sort a vector of movies using several threads (merge sort).
+         * 
+         * \c sort uses it automatically above \c parallel::threshold().
+         * 
+         * \param movies Vector of movies to sort.
+         * \param cmp Comparison function.
+         * \param nb_threads Number of threads to use.
+         */
+        void parallel_sort(
+            std::vector<data::movie_ref> &movies,
+            sort_func cmp,
+            size_t nb_threads
+        );
+
+        /**
+         * \brief Keep only the first \p k movies of the sorted order.
+         *
+         * Uses a partial sort: costs O(n log k) instead of O(n log n).
+         *
+         * \param movies Vector of movies, replaced by its \p k first movies
+         *               in sorted order (or all movies if there are fewer).
+         * \param k Number of movies to keep.
+         * \param cmp Comparison function.
+         */
+        void top_k(std::vector<data::movie_ref> &movies, size_t k,
+                   sort_func cmp);
+
+        /**
+         * \brief Keep only a range of the sorted order (e.g. a page).
+         *
+         * Uses a selection then a partial sort: costs O(n log count)
+         * instead of O(n log n).
+         *
+         * \param movies Vector of movies, replaced by the movies at positions
+         *               [offset; offset+count[ of the sorted order.
+         * \param offset Position of the first movie to keep.
+         * \param count Maximum number of movies to keep.
+         * \param cmp Comparison function.
+         */
+        void sort_range(
+            std::vector<data::movie_ref> &movies,
+            size_t offset,
+            size_t count,
+            sort_func cmp
+        );
+
         /**
          * \brief Get a comparison function to sort movies by title.
          * \param ascending True for ascending order, false for descending.
@@ -66,22 +170,256 @@ namespace core {
          */
         sort_func sort_by_duration(bool ascending = true);
 
+        /**
+         * \brief Get the comparison function to sort movies by a field.
+         * \param f Field to sort by.
+         * \param ascending True for ascending order, false for descending.
+         * \return Comparison function (same as the \c sort_by_* functions).
+         */
+        sort_func sort_by(field f, bool ascending);
+
+
+        // --- Composed comparators ---
+
+        /// Tag selecting an ascending order for a comparator key.
+        struct ascending_t {};
+        /// Tag selecting a descending order for a comparator key.
+        struct descending_t {};
+
+        inline constexpr ascending_t asc{};   ///< Ascending order tag.
+        inline constexpr descending_t desc{}; ///< Descending order tag.
+
+        /**
+         * \brief A key of a composed comparator.
+         * \tparam Getter Accessor (e.g. \c &data::Movie::year) or any
+         *         callable taking a \c const data::Movie&.
+         * \tparam Ascending Order of this key.
+         */
+        template <typename Getter, bool Ascending>
+        struct comparator_key {
+            static constexpr bool ascending = Ascending; ///< Key order.
+            Getter getter; ///< Accessor of the compared value.
+        };
+
+        /**
+         * \brief Comparator composed of several keys, compared in order.
+         *
+         * Built with \c by and \c then, e.g.:
+         * @code
+         * sorting::sort(movies, sorting::by(&data::Movie::year, sorting::desc)
+         *                           .then(&data::Movie::title));
+         * @endcode
+         * Keys and orders are part of the type, so comparisons are inlined
+         * by \c std::sort (unlike a \c sort_func).
+         */
+        template <typename... Keys>
+        class comparator {
+        public:
+            /// Construct from its keys (prefer \c by and \c then).
+            constexpr explicit comparator(std::tuple<Keys...> keys):
+                _keys(keys) {}
+
+            /**
+             * \brief Add a key used when all previous keys are equal.
+             * \param getter Accessor of the compared value.
+             * \param order \c asc (default) or \c desc.
+             * \return A new comparator.
+             */
+            template <typename Getter, typename Order = ascending_t>
+            constexpr auto then(Getter getter, Order order = {}) const {
+                (void) order;
+                constexpr bool ascending = std::is_same_v<Order, ascending_t>;
+                return comparator<Keys..., comparator_key<Getter, ascending>>(
+                    std::tuple_cat(_keys, std::make_tuple(
+                        comparator_key<Getter, ascending>{getter})));
+            }
+
+            /// Compare two movies: true if \p m1 comes before \p m2.
+            bool operator()(
+                const data::movie_ref m1, const data::movie_ref m2
+            ) const {
+                return less<0>(m1.get(), m2.get());
+            }
+
+        private:
+            template <size_t I>
+            bool less(const data::Movie &m1, const data::Movie &m2) const {
+                if constexpr (I == sizeof...(Keys)) return false;
+                else {
+                    using key = std::tuple_element_t<I, std::tuple<Keys...>>;
+                    constexpr bool ascending = key::ascending;
+                    const auto &v1 = std::invoke(std::get<I>(_keys).getter, m1);
+                    const auto &v2 = std::invoke(std::get<I>(_keys).getter, m2);
+                    if (v1 < v2) return ascending;
+                    if (v2 < v1) return !ascending;
+                    return less<I + 1>(m1, m2);
+                }
+            }
+
+            std::tuple<Keys...> _keys; ///< Keys, in comparison order.
+        };
+
+        /**
+         * \brief Start a composed comparator with its first key.
+         * \param getter Accessor of the compared value.
+         * \param order \c asc (default) or \c desc.
+         * \return A comparator, to be extended with \c then.
+         */
+        template <typename Getter, typename Order = ascending_t>
+        constexpr auto by(Getter getter, Order order = {}) {
+            return comparator<>(std::tuple<>()).then(getter, order);
+        }
+
+        /**
+         * \brief Sort a vector of movies using a composed comparator.
+         * \param movies Vector of movies to sort.
+         * \param cmp Comparator built with \c by and \c then.
+         */
+        template <typename... Keys>
+        void sort(
+            std::vector<data::movie_ref> &movies,
+            const comparator<Keys...> &cmp
+        ) {
+            std::sort(movies.begin(), movies.end(), cmp);
+        }
+
+        /**
+         * \class SortedIndex
+         * \brief Movies kept sorted by a field, updated incrementally.
+         *
+         * The order is the same as the one given by \c sort_by for this
+         * field, in both directions. Insertions, removals and updates cost
+         * O(log n), so an ordered range can be returned without sorting.
+         *
+         * \note Each movie field value is copied when inserted or updated:
+         *       call \c update after editing a movie.
+         */
+        class SortedIndex {
+        public:
+            /**
+             * \brief Construct an empty index.
+             * \param f Field used to sort.
+             */
+            explicit SortedIndex(field f);
+
+            /// Not copyable: positions refer to the internal set.
+            SortedIndex(const SortedIndex &) = delete;
+            SortedIndex &operator=(const SortedIndex &) = delete;
+
+            /**
+             * \brief Add a movie (nothing happens if already indexed).
+             * \param m Movie to add (non-owning, must outlive the index).
+             */
+            void insert(data::Movie &m);
+
+            /**
+             * \brief Remove a movie (nothing happens if not indexed).
+             * \param m Movie to remove.
+             */
+            void erase(const data::Movie &m);
+
+            /**
+             * \brief Move a movie after its field has been edited.
+             * \param m Edited movie.
+             */
+            void update(data::Movie &m);
+
+            /**
+             * \brief  Get the number of indexed movies.
+             * \return Number of movies.
+             */
+            size_t size() const;
+
+            /**
+             * \brief Get a sorted range of movies.
+             * \param ascending True for ascending order, false for descending.
+             * \param offset Starting position (walked in O(offset)).
+             * \param count Maximum number of movies to return.
+             * \return Vector of movies, already sorted.
+             */
+            std::vector<data::movie_ref> range(
+                bool ascending, size_t offset, size_t count) const;
+
+            /**
+             * \brief Get the sorted range of movies following a movie.
+             * \param m Last movie before the range (cursor).
+             * \param ascending True for ascending order, false for descending.
+             * \param count Maximum number of movies to return.
+             * \return Vector of movies, already sorted. Empty if \p m is not
+             *         indexed.
+             */
+            std::vector<data::movie_ref> range_after(
+                const data::Movie &m, bool ascending, size_t count) const;
+
+        private:
+            /// Snapshot of the sorting key of a movie.
+            struct key {
+                int number;         ///< Numeric field value (year, duration).
+                std::string text;   ///< Text field value (category, director).
+                data::Movie *movie; ///< Indexed movie (title is the tiebreak).
+
+                bool operator<(const key &other) const;
+            };
+
+            using iterator = std::set<key>::const_iterator;
+
+            /// Build the key of a movie with its current values.
+            key make_key(data::Movie &m) const;
+
+            /// First movie in the given order.
+            iterator first(bool ascending) const;
+
+            /// Movie following \c it in the given order.
+            iterator next(iterator it, bool ascending) const;
+
+            /// First movie having the same field value as \c it.
+            iterator group_begin(iterator it) const;
+
+            /// Collect up to \c count movies from \c it.
+            std::vector<data::movie_ref> collect(
+                iterator it, bool ascending, size_t count) const;
+
+            const field _field;   ///< Field used to sort.
+            std::set<key> _keys;  ///< Sorted keys (ascending order).
+            /// Position of each indexed movie in \c _keys.
+            std::unordered_map<const data::Movie*, iterator> _positions;
+        };
+
     } // namespace sorting
 
     /**
      * \namespace selection
      * \brief Functions to select movies from a vector according to criteria.
+     *
+     * Above \c parallel::threshold() movies, the vector is filtered by
+     * chunks on several threads. The order of movies is always preserved.
      */
     namespace selection {
 
+        /**
+         * \enum match
+         * \brief How a text value is compared to the movies values.
+         */
+        enum match {
+            EXACT,      ///< Same bytes.
+            /// Same key by \c core::slug: ignores case and accents (e.g.
+            /// "amelie" matches "Amélie"). Movies keys are precomputed (see
+            /// \c data::Movie::title_key), so only \p value is converted.
+            NORMALIZED
+        };
+
         /**
          * \brief Select movies with a specific title.
          * \param movies Vector of movies to search.
          * \param value Title to match.
+         * \param mode Comparison of the titles (default exact).
          * \return Vector of movies with the specified title.
          */
         std::vector<data::movie_ref> select_by_title(
-            const std::vector<data::movie_ref> &movies, const std::string &value);
+            const std::vector<data::movie_ref> &movies,
+            const std::string &value,
+            match mode = EXACT
+        );
         
         /**
          * \brief Select movies released in a specific year, optionally within a range.
@@ -98,19 +436,40 @@ namespace core {
          * \brief Select movies with a specific category/genre.
          * \param movies Vector of movies to search.
          * \param value Category to match.
+         * \param mode Comparison of the categories (default exact).
          * \return Vector of movies with the specified category.
          */
         std::vector<data::movie_ref> select_by_category(
-            const std::vector<data::movie_ref> &movies, const std::string &value);
+            const std::vector<data::movie_ref> &movies,
+            const std::string &value,
+            match mode = EXACT
+        );
 
         /**
          * \brief Select movies directed by a specific director.
          * \param movies Vector of movies to search.
          * \param value Director name to match.
+         * \param mode Comparison of the directors (default exact).
          * \return Vector of movies directed by the specified director.
          */
         std::vector<data::movie_ref> select_by_director(
-            const std::vector<data::movie_ref> &movies, const std::string &value);
+            const std::vector<data::movie_ref> &movies,
+            const std::string &value,
+            match mode = EXACT
+        );
+
+        /**
+         * \brief Select movies featuring a specific actor.
+         * \param movies Vector of movies to search.
+         * \param value Actor name to match (one of \c data::Movie::actor_list,
+         *              not a substring of the actors string).
+         * \return Vector of movies featuring the specified actor.
+         * \note  Scans all movies: to select among the movies of a catalog,
+         *        \c BasicCatalog::movies_by_actor reads an index instead.
+         */
+        std::vector<data::movie_ref> select_by_actor(
+            const std::vector<data::movie_ref> &movies,
+            const std::string &value);
 
         /**
          * \brief Select movies with a specific duration, optionally within a delta.
@@ -123,6 +482,128 @@ namespace core {
         std::vector<data::movie_ref> select_by_duration(
             const std::vector<data::movie_ref> &movies, int value, int delta);
 
+        /**
+         * \struct Facets
+         * \brief Number of movies for each value of the browsable fields.
+         */
+        struct Facets {
+            size_t total = 0; ///< Number of movies.
+            std::map<std::string, size_t> categories; ///< Per category.
+            std::map<int, size_t> years;              ///< Year histogram.
+            std::map<std::string, size_t> directors;  ///< Per director.
+
+            /// Check if both facets have the same counts.
+            bool operator==(const Facets &other) const;
+        };
+
+        /**
+         * \brief Count movies per category, year and director, in one pass.
+         * \param movies Vector of movies to count.
+         * \return Counts of the movies (values without movies are absent).
+         */
+        Facets facets(const std::vector<data::movie_ref> &movies);
+
+        /**
+         * \class Query
+         * \brief Lazy conjunction of selection criteria.
+         *
+         * Unlike chained \c select_by_* calls, which each copy the matching
+         * movies, criteria are only recorded and then evaluated together in
+         * a single pass. The most selective criteria are tested first, and
+         * the pass stops as soon as the requested page is full.
+         *
+         * Example: the second page of 24 dramas from the 90s:
+         * @code
+         * auto page = selection::Query().category("Drame").year(1995, 5)
+         *     .run(movies, 24, 24);
+         * @endcode
+         */
+        class Query {
+        public:
+            /// Keep movies with a specific title (see \c match).
+            Query &title(const std::string &value, match mode = EXACT);
+
+            /// Keep movies released in [value-delta; value+delta].
+            Query &year(int value, int delta = 0);
+
+            /// Keep movies with a specific category/genre (see \c match).
+            Query &category(const std::string &value, match mode = EXACT);
+
+            /// Keep movies directed by a specific director (see \c match).
+            Query &director(const std::string &value, match mode = EXACT);
+
+            /// Keep movies lasting [value-delta; value+delta] minutes.
+            Query &duration(int value, int delta = 0);
+
+            /**
+             * \brief Keep movies matching a custom predicate.
+             * \param pred Predicate on a movie.
+             * \param selectivity Estimated fraction of movies matching
+             *        \p pred (in [0; 1]), used to order criteria.
+             * \return This query.
+             */
+            Query &where(
+                std::function<bool(const data::Movie&)> pred,
+                double selectivity = 1.0
+            );
+
+            /**
+             * \brief Check whether a movie matches all criteria.
+             * \param movie Movie to test.
+             * \return True if the movie matches (always for an empty query).
+             */
+            bool matches(const data::Movie &movie) const;
+
+            /**
+             * \brief Get a page of the matching movies, in their original
+             *        order.
+             * \param movies Vector of movies to search.
+             * \param offset Number of matching movies to skip.
+             * \param count Maximum number of movies to return.
+             * \return Matching movies at positions [offset; offset+count[.
+             */
+            std::vector<data::movie_ref> run(
+                const std::vector<data::movie_ref> &movies,
+                size_t offset = 0,
+                size_t count = SIZE_MAX
+            ) const;
+
+            /**
+             * \brief Count the matching movies.
+             * \param movies Vector of movies to search.
+             * \return Number of movies matching all criteria.
+             */
+            size_t count(const std::vector<data::movie_ref> &movies) const;
+
+            /// A recorded criterion (implementation detail).
+            struct criterion {
+                enum {
+                    TITLE, YEAR, CATEGORY, DIRECTOR, DURATION, CUSTOM,
+                    TITLE_KEY, CATEGORY_KEY, DIRECTOR_KEY ///< Normalized.
+                } kind;
+                std::string text; ///< Expected text value (or key).
+                int min, max;     ///< Accepted numeric interval.
+                std::function<bool(const data::Movie&)> pred; ///< CUSTOM.
+                double selectivity; ///< Estimated fraction of matches.
+            };
+
+        private:
+            /// Insert a criterion, keeping the most selective first.
+            Query &add(criterion c);
+
+            /// Call \p on_match for each matching movie of [begin; end[,
+            /// until it returns false.
+            template <typename Callback>
+            void scan(
+                const std::vector<data::movie_ref> &movies,
+                size_t begin,
+                size_t end,
+                Callback on_match
+            ) const;
+
+            std::vector<criterion> _criteria; ///< Sorted by selectivity.
+        };
+
     } // namespace selection
 
 } // namespace core
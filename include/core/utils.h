@@ -6,6 +6,7 @@
 #include <vector>
 #include <functional>
 #include <optional>
+#include <cstdint>
 
 /**
  * \file csv.h
@@ -51,6 +52,52 @@ namespace core {
          */
         void read(std::istream &in, row_callback on_row);
 
+        /**
+         * \brief Callback type called for each row during indexed CSV parsing.
+         *
+         * Same as \c row_callback, but also receives the byte offset of the
+         * first character of the row in the input stream.
+         *
+         * \throw FoundException If the callback wants to stop parsing early.
+         */
+        using indexed_row_callback =
+            std::function<void(std::vector<std::string>&, std::streamoff)>;
+
+        /**
+         * \brief Read a CSV stream and call a callback for each row with its
+         *        starting offset.
+         *
+         * The offsets given to the callback can later be used with
+         * \c read_row_at to read a single row without scanning the stream.
+         *
+         * \param in The input stream containing CSV data (read from its
+         *           current position).
+         * \param on_row A function called for each parsed row, with its
+         *               offset, or -1 if the offset is unknown.
+         *
+         * \throw std::runtime_error If libcsv encounters a parsing error.
+         *
+         * \note Row boundaries are detected with the quoting rules of libcsv,
+         *       and blank lines are skipped. Each row is checked against
+         *       libcsv: if they disagree, the remaining rows are parsed by
+         *       libcsv from the whole stream (which must be seekable), and
+         *       given with an offset of -1.
+         */
+        void read_indexed(std::istream &in, indexed_row_callback on_row);
+
+        /**
+         * \brief Read the single row starting at a given offset.
+         *
+         * \param in The input stream containing CSV data.
+         * \param offset Byte offset of the row, as given by \c read_indexed.
+         * \return The fields of the row, or std::nullopt if there is no row
+         *         at this offset.
+         *
+         * \throw std::runtime_error If libcsv encounters a parsing error.
+         */
+        std::optional<std::vector<std::string>> read_row_at(
+            std::istream &in, std::streamoff offset);
+
         /**
          * \brief Write a single CSV field to an output stream, escaping as 
          *        necessary.
@@ -146,10 +193,11 @@ namespace core {
      * \brief Converts a string into a "slug" suitable for URLs or identifiers.
      * 
      * This function performs the following transformations on the input string:
-     * 1. Replaces accented or special characters (e.g., à, é, ü, ç) with their
-     *    ASCII equivalents (e.g., a, e, u, c).
+     * 1. Decodes it as UTF-8 and replaces Latin letters (U+00C0 to U+017F,
+     *    lowercase or uppercase, e.g. à, É, ü, ç, Œ) with their ASCII
+     *    equivalents (e.g. a, e, u, c, oe).
      * 2. Converts all characters to lowercase.
-     * 3. Replaces any non-alphanumeric characters with underscores ('_').
+     * 3. Replaces any other character with underscores ('_'), one per byte.
      * 
      * Example:
      * @code
@@ -163,6 +211,19 @@ namespace core {
      */
     std::string slug(const std::string &src);
 
+    /**
+     * \brief Compute the 64 bits FNV-1a hash of a string.
+     *
+     * The hash is stable across runs and platforms, so it can be stored
+     * (e.g. in the search index) to detect changes later.
+     *
+     * \param src The string to hash.
+     * \param h Hash to continue from, to hash several strings in turn.
+     * \return The hash of \p src (following \p h).
+     */
+    uint64_t fnv1a(const std::string &src,
+                   uint64_t h = 14695981039346656037ULL);
+
 } // namespace core
 
 #endif // CSV_HPP
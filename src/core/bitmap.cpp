@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+#include "core/bitmap.h"
+
+using namespace std;
+using namespace core;
+
+// Above this number of values, a container is stored as a bitset
+// (4096 values in an array use as much memory as a 65536 bits bitset).
+// It goes back to an array below a lower size only, so that adding and
+// removing a value around the limit does not convert it each time.
+namespace {
+    constexpr size_t ARRAY_MAX_SIZE = 4096;
+    constexpr size_t BITSET_MIN_SIZE = 3584;
+    constexpr size_t BITSET_WORDS = 1024;
+}
+
+static bool test_bit(const vector<uint64_t> &bits, uint16_t v) {
+    return (bits[v >> 6] >> (v & 63)) & 1;
+}
+
+static uint32_t popcount(const vector<uint64_t> &bits) {
+    uint32_t n = 0;
+    for (uint64_t w: bits) n += __builtin_popcountll(w);
+    return n;
+}
+
+static void to_bitset(vector<uint16_t> &array, vector<uint64_t> &bits) {
+    bits.assign(BITSET_WORDS, 0);
+    for (uint16_t v: array) bits[v >> 6] |= uint64_t(1) << (v & 63);
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void Bitmap::normalize(container &c) {
+    if (c.is_bitset() && c.cardinality < BITSET_MIN_SIZE) {
+        c.array.clear();
+        c.array.reserve(c.cardinality);
+        for (size_t w = 0; w < BITSET_WORDS; w++)
+            for (uint64_t word = c.bits[w]; word != 0; word &= word - 1)
+                c.array.push_back(w * 64 + __builtin_ctzll(word));
+        c.bits.clear();
+        c.bits.shrink_to_fit();
+    }
+    else if (!c.is_bitset() && c.cardinality > ARRAY_MAX_SIZE)
+        to_bitset(c.array, c.bits);
+}
+
+void Bitmap::add(uint32_t x) {
+    uint16_t key = x >> 16, low = x & 0xFFFF;
+    auto it = lower_bound(_containers.begin(), _containers.end(), key,
+        [](const container &c, uint16_t k) { return c.key < k; });
+    if (it == _containers.end() || it->key != key)
+        it = _containers.insert(it, container{key, 0, {}, {}});
+
+    if (it->is_bitset()) {
+        if (test_bit(it->bits, low)) return;
+        it->bits[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    else {
+        auto pos = lower_bound(it->array.begin(), it->array.end(), low);
+        if (pos != it->array.end() && *pos == low) return;
+        it->array.insert(pos, low);
+    }
+    it->cardinality++;
+    normalize(*it);
+}
+
+void Bitmap::remove(uint32_t x) {
+    uint16_t key = x >> 16, low = x & 0xFFFF;
+    auto it = lower_bound(_containers.begin(), _containers.end(), key,
+        [](const container &c, uint16_t k) { return c.key < k; });
+    if (it == _containers.end() || it->key != key) return;
+
+    if (it->is_bitset()) {
+        if (!test_bit(it->bits, low)) return;
+        it->bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+    }
+    else {
+        auto pos = lower_bound(it->array.begin(), it->array.end(), low);
+        if (pos == it->array.end() || *pos != low) return;
+        it->array.erase(pos);
+    }
+
+    if (--it->cardinality == 0) _containers.erase(it);
+    else normalize(*it);
+}
+
+bool Bitmap::contains(uint32_t x) const {
+    uint16_t key = x >> 16, low = x & 0xFFFF;
+    auto it = lower_bound(_containers.begin(), _containers.end(), key,
+        [](const container &c, uint16_t k) { return c.key < k; });
+    if (it == _containers.end() || it->key != key) return false;
+
+    if (it->is_bitset()) return test_bit(it->bits, low);
+    return binary_search(it->array.begin(), it->array.end(), low);
+}
+
+size_t Bitmap::cardinality() const {
+    size_t n = 0;
+    for (const container &c: _containers) n += c.cardinality;
+    return n;
+}
+
+bool Bitmap::empty() const { return _containers.empty(); }
+
+void Bitmap::for_each(const function<bool(uint32_t)> &f) const {
+    for (const container &c: _containers) {
+        uint32_t high = uint32_t(c.key) << 16;
+        if (!c.is_bitset()) {
+            for (uint16_t v: c.array)
+                if (!f(high | v)) return;
+            continue;
+        }
+        for (size_t w = 0; w < BITSET_WORDS; w++)
+            for (uint64_t word = c.bits[w]; word != 0; word &= word - 1)
+                if (!f(high | (w * 64 + __builtin_ctzll(word)))) return;
+    }
+}
+
+vector<uint32_t> Bitmap::values() const {
+    vector<uint32_t> v;
+    v.reserve(cardinality());
+    for_each([&v](uint32_t x) {
+        v.push_back(x);
+        return true;
+    });
+    return v;
+}
+
+/*
+ * Set operations
+ */
+
+Bitmap::container Bitmap::intersect(const container &c1, const container &c2) {
+    container r{c1.key, 0, {}, {}};
+
+    if (c1.is_bitset() && c2.is_bitset()) {
+        r.bits.resize(BITSET_WORDS);
+        for (size_t w = 0; w < BITSET_WORDS; w++)
+            r.bits[w] = c1.bits[w] & c2.bits[w];
+        r.cardinality = popcount(r.bits);
+    }
+    else if (c1.is_bitset() || c2.is_bitset()) {
+        const container &a = c1.is_bitset() ? c2 : c1;
+        const container &b = c1.is_bitset() ? c1 : c2;
+        for (uint16_t v: a.array)
+            if (test_bit(b.bits, v)) r.array.push_back(v);
+        r.cardinality = r.array.size();
+    }
+    else {
+        set_intersection(c1.array.begin(), c1.array.end(),
+                         c2.array.begin(), c2.array.end(),
+                         back_inserter(r.array));
+        r.cardinality = r.array.size();
+    }
+
+    normalize(r);
+    return r;
+}
+
+Bitmap::container Bitmap::unite(const container &c1, const container &c2) {
+    container r{c1.key, 0, {}, {}};
+
+    if (c1.is_bitset() || c2.is_bitset()) {
+        const container &a = c1.is_bitset() ? c2 : c1;
+        const container &b = c1.is_bitset() ? c1 : c2;
+        r.bits = b.bits;
+        if (a.is_bitset())
+            for (size_t w = 0; w < BITSET_WORDS; w++) r.bits[w] |= a.bits[w];
+        else
+            for (uint16_t v: a.array) r.bits[v >> 6] |= uint64_t(1) << (v & 63);
+        r.cardinality = popcount(r.bits);
+    }
+    else {
+        r.array.reserve(c1.array.size() + c2.array.size());
+        set_union(c1.array.begin(), c1.array.end(),
+                  c2.array.begin(), c2.array.end(),
+                  back_inserter(r.array));
+        r.cardinality = r.array.size();
+    }
+
+    normalize(r);
+    return r;
+}
+
+Bitmap Bitmap::operator&(const Bitmap &other) const {
+    Bitmap r;
+    auto it1 = _containers.begin(), it2 = other._containers.begin();
+    while (it1 != _containers.end() && it2 != other._containers.end()) {
+        if (it1->key < it2->key) it1++;
+        else if (it2->key < it1->key) it2++;
+        else {
+            container c = intersect(*it1++, *it2++);
+            if (c.cardinality > 0) r._containers.push_back(move(c));
+        }
+    }
+    return r;
+}
+
+Bitmap Bitmap::operator|(const Bitmap &other) const {
+    Bitmap r;
+    auto it1 = _containers.begin(), it2 = other._containers.begin();
+    while (it1 != _containers.end() || it2 != other._containers.end()) {
+        if (it2 == other._containers.end()
+            || (it1 != _containers.end() && it1->key < it2->key))
+            r._containers.push_back(*it1++);
+        else if (it1 == _containers.end() || it2->key < it1->key)
+            r._containers.push_back(*it2++);
+        else
+            r._containers.push_back(unite(*it1++, *it2++));
+    }
+    return r;
+}
+
+Bitmap Bitmap::union_of(const vector<const Bitmap*> &bitmaps) {
+    // containers of all bitmaps, grouped by key
+    map<uint16_t, vector<const container*>> groups;
+    for (const Bitmap *b: bitmaps)
+        for (const container &c: b->_containers) groups[c.key].push_back(&c);
+
+    Bitmap r;
+    r._containers.reserve(groups.size());
+    for (auto &[key, group]: groups) {
+        if (group.size() == 1) {
+            r._containers.push_back(*group[0]);
+            continue;
+        }
+
+        // accumulated in a bitset, then converted back if sparse
+        container u{key, 0, {}, vector<uint64_t>(BITSET_WORDS, 0)};
+        for (const container *c: group) {
+            if (c->is_bitset())
+                for (size_t w = 0; w < BITSET_WORDS; w++) u.bits[w] |= c->bits[w];
+            else
+                for (uint16_t v: c->array)
+                    u.bits[v >> 6] |= uint64_t(1) << (v & 63);
+        }
+        u.cardinality = popcount(u.bits);
+        normalize(u);
+        r._containers.push_back(move(u));
+    }
+    return r;
+}
+
+Bitmap &Bitmap::operator&=(const Bitmap &other) {
+    *this = *this & other;
+    return *this;
+}
+
+// In place, so that accumulating many bitmaps (e.g. year buckets) updates
+// bitsets directly instead of copying the result each time
+Bitmap &Bitmap::operator|=(const Bitmap &other) {
+    auto it = _containers.begin();
+    for (const container &c: other._containers) {
+        it = lower_bound(it, _containers.end(), c.key,
+            [](const container &c1, uint16_t k) { return c1.key < k; });
+
+        if (it == _containers.end() || it->key != c.key) {
+            it = _containers.insert(it, c);
+            it++;
+            continue;
+        }
+
+        // a union which may not fit in an array is done in a bitset
+        if (!it->is_bitset() && it->cardinality + c.cardinality > ARRAY_MAX_SIZE)
+            to_bitset(it->array, it->bits);
+
+        if (!it->is_bitset())
+            *it = unite(*it, c);
+        else {
+            if (c.is_bitset())
+                for (size_t w = 0; w < BITSET_WORDS; w++) it->bits[w] |= c.bits[w];
+            else
+                for (uint16_t v: c.array)
+                    it->bits[v >> 6] |= uint64_t(1) << (v & 63);
+            it->cardinality = popcount(it->bits);
+            normalize(*it);
+        }
+        it++;
+    }
+    return *this;
+}
+
+bool Bitmap::operator==(const Bitmap &other) const {
+    if (_containers.size() != other._containers.size()) return false;
+    for (size_t i = 0; i < _containers.size(); i++) {
+        const container &c1 = _containers[i], &c2 = other._containers[i];
+        if (c1.key != c2.key || c1.cardinality != c2.cardinality)
+            return false;
+
+        // same values stored differently (see normalize): each value of the
+        // array must be in the bitset
+        if (c1.is_bitset() != c2.is_bitset()) {
+            const container &a = c1.is_bitset() ? c2 : c1;
+            const container &b = c1.is_bitset() ? c1 : c2;
+            for (uint16_t v: a.array)
+                if (!test_bit(b.bits, v)) return false;
+        }
+        else if (c1.array != c2.array || c1.bits != c2.bits)
+            return false;
+    }
+    return true;
+}
@@ -5,6 +5,7 @@
 
 #include "core/catalog.h"
 #include "core/utils.h"
+#include "core/scan.h"
 
 using namespace std;
 using namespace core;
@@ -47,9 +48,20 @@ reference_wrapper<data::SynopsisProvider>
             CONSTRUCTORS HELPER
  -------------------------------------------*/
 
+// Position of a movie row in its CSV file.
+struct csv_location {
+    streamoff offset;       // byte offset of the row (-1 if not indexed)
+    size_t title_column;    // index of the "title" column
+    size_t synopsis_column; // index of the "synopsis" column
+};
+
 // Parse a CSV file and build FullMovie objects.
-// For each row, call the provided function f(movie).
-static void parse_csv(string filename, function<void(data::Movie&)> f) {
+// For each row, call the provided function f(movie, location).
+// Row offsets are only computed if `indexed` is true.
+static void parse_csv_rows(
+    string filename, bool indexed,
+    function<void(data::Movie&, const csv_location&)> f
+) {
     ifstream in(filename);
     if (!in.is_open()) throw runtime_error("Cannot open file: " + filename);
 
@@ -68,7 +80,7 @@ static void parse_csv(string filename, function<void(data::Movie&)> f) {
     int duration_index = -1;
 
     // Function called for each row
-    csv::row_callback on_row = [&](vector<string> row) {
+    csv::indexed_row_callback on_row = [&](vector<string> &row, streamoff o) {
         // First row = header -> find column indexes
         if (is_first) {
             // locate each column by name
@@ -129,7 +141,7 @@ static void parse_csv(string filename, function<void(data::Movie&)> f) {
                     data::Cover(row[cover_normal_index], row[cover_square_index]),
                     row[video_file_index]
                 );
-                f(m);
+                f(m, {o, (size_t) title_index, (size_t) synopsis_index});
             }
             catch (const std::out_of_range &e) {
                 throw runtime_error("Missing column(s)");
@@ -137,11 +149,21 @@ static void parse_csv(string filename, function<void(data::Movie&)> f) {
         }
     };
 
-    csv::read(in, on_row);
+    if (indexed)
+        csv::read_indexed(in, on_row);
+    else
+        csv::read(in, [&on_row](vector<string> &row) { on_row(row, -1); });
 
     in.close();
 }
 
+// Parse a CSV file and build FullMovie objects.
+// For each row, call the provided function f(movie).
+static void parse_csv(string filename, function<void(data::Movie&)> f) {
+    parse_csv_rows(filename, false,
+        [&f](data::Movie &m, const csv_location&) -> void { f(m); });
+}
+
 
 /*------------------------------------------
                BASIC CATALOG
@@ -169,27 +191,215 @@ BasicCatalog::BasicCatalog(const string& filename) {
 
 void BasicCatalog::add(unique_ptr<data::Movie> m) {
     // checks first if already exist in this catalog
-    if (!get_movie(m.get()->title()))
+    auto inserted = _positions.emplace(m.get()->title(), _data.size());
+    if (inserted.second) {
+        for (auto &index: _indexes) index.insert(*m);
+        _data_slots.push_back(add_slot(m.get()));
+        _years.push_back(m->year());
+        _durations.push_back(m->duration());
         _data.push_back(move(m));
+        _version++;
+    }
+}
+
+vector<data::movie_ref> BasicCatalog::add_bulk(
+    vector<unique_ptr<data::Movie>> movies
+) {
+    vector<data::movie_ref> added;
+    added.reserve(movies.size());
+    _data.reserve(_data.size() + movies.size());
+    _positions.reserve(_data.size() + movies.size());
+
+    // duplicates (in the catalog or in the batch itself) are skipped
+    for (auto &m: movies) {
+        auto inserted = _positions.emplace(m.get()->title(), _data.size());
+        if (!inserted.second) continue;
+
+        for (auto &index: _indexes) index.insert(*m);
+        _data_slots.push_back(add_slot(m.get()));
+        _years.push_back(m->year());
+        _durations.push_back(m->duration());
+        added.push_back(ref(*m));
+        _data.push_back(move(m));
+    }
+
+    if (!added.empty()) _version++;
+
+    return added;
 }
 
 void BasicCatalog::remove(const string &title) {
-    size_t i = 0;
-    while (i < _data.size() && _data[i].get()->title() != title) i++;
-    
-    if (i != _data.size())
-        _data.erase(next(_data.begin(), i));
+    auto it = _positions.find(title);
+    if (it == _positions.end()) return;
+
+    size_t i = it->second;
+    _positions.erase(it);
+    for (auto &index: _indexes) index.erase(*_data[i]);
+    // the slot is emptied (its values are no longer needed) then reused
+    unindex_slot(_data_slots[i]);
+    _slots[_data_slots[i]] = {nullptr, "", "", 0, {}};
+    _free_slots.push_back(_data_slots[i]);
+    _data_slots.erase(next(_data_slots.begin(), i));
+    _years.erase(next(_years.begin(), i));
+    _durations.erase(next(_durations.begin(), i));
+    _data.erase(next(_data.begin(), i));
+    _version++;
+
+    // following movies are shifted
+    for (size_t j = i; j < _data.size(); j++)
+        _positions[_data[j].get()->title()] = j;
+}
+
+void BasicCatalog::refresh(const string &title) {
+    optional<size_t> i = get_index(title);
+    if (!i.has_value()) return;
+    for (auto &index: _indexes) index.update(*_data[i.value()]);
+    unindex_slot(_data_slots[i.value()]);
+    index_slot(_data_slots[i.value()]);
+    _years[i.value()] = _data[i.value()]->year();
+    _durations[i.value()] = _data[i.value()]->duration();
+    _version++;
+}
+
+shared_ptr<const selection::Facets> BasicCatalog::facets() const {
+    if (_facets != nullptr && _facets_version == _version)
+        return _facets;
+
+    // new counts: the previous ones may still be held by callers
+    auto f = make_shared<selection::Facets>();
+    f->total = _data.size();
+    for (auto &[category, b]: _category_bitmaps)
+        f->categories.emplace(category, b.cardinality());
+    for (auto &[director, b]: _director_bitmaps)
+        f->directors.emplace(director, b.cardinality());
+    for (auto &[year, b]: _year_bitmaps)
+        f->years.emplace(year, b.cardinality());
+
+    _facets = move(f);
+    _facets_version = _version;
+    return _facets;
+}
+
+uint64_t BasicCatalog::version() const { return _version; }
+
+uint32_t BasicCatalog::add_slot(data::Movie *m) {
+    uint32_t s = _slots.size();
+    if (_free_slots.empty()) _slots.push_back({m, "", "", 0, {}});
+    else {
+        s = _free_slots.back();
+        _free_slots.pop_back();
+        _slots[s].movie = m;
+    }
+    index_slot(s);
+    return s;
+}
+
+void BasicCatalog::index_slot(uint32_t s) {
+    slot &sl = _slots[s];
+    sl.category = sl.movie->category();
+    sl.director = sl.movie->director();
+    sl.year = sl.movie->year();
+    sl.actors = sl.movie->actor_list();
+
+    _category_bitmaps[sl.category].add(s);
+    _director_bitmaps[sl.director].add(s);
+    _year_bitmaps[sl.year].add(s);
+    for (const string &actor: sl.actors) _actor_bitmaps[actor].add(s);
+}
+
+// Remove the slot from the bitmaps of its indexed values (empty bitmaps
+// are dropped so that removed values do not accumulate)
+void BasicCatalog::unindex_slot(uint32_t s) {
+    const slot &sl = _slots[s];
+    auto unindex = [s](auto &bitmaps, const auto &value) {
+        auto it = bitmaps.find(value);
+        if (it == bitmaps.end()) return;
+        it->second.remove(s);
+        if (it->second.empty()) bitmaps.erase(it);
+    };
+    unindex(_category_bitmaps, sl.category);
+    unindex(_director_bitmaps, sl.director);
+    unindex(_year_bitmaps, sl.year);
+    for (const string &actor: sl.actors) unindex(_actor_bitmaps, actor);
+}
+
+vector<data::movie_ref> BasicCatalog::movies_at(
+    const vector<uint32_t> &positions
+) const {
+    vector<data::movie_ref> result;
+    result.reserve(positions.size());
+    for (uint32_t i: positions) result.push_back(ref(*_data[i]));
+    return result;
+}
+
+vector<data::movie_ref> BasicCatalog::movies_by_year(int val, int delta) const {
+    return movies_at(scan::range(_years.data(), _years.size(),
+                                 val - delta, val + delta));
+}
+
+vector<data::movie_ref> BasicCatalog::movies_by_duration(
+    int val, int delta
+) const {
+    return movies_at(scan::range(_durations.data(), _durations.size(),
+                                 val - delta, val + delta));
+}
+
+const Bitmap &BasicCatalog::category_bitmap(const string &category) const {
+    static const Bitmap empty;
+    auto it = _category_bitmaps.find(category);
+    return (it == _category_bitmaps.end()) ? empty : it->second;
+}
+
+const Bitmap &BasicCatalog::director_bitmap(const string &director) const {
+    static const Bitmap empty;
+    auto it = _director_bitmaps.find(director);
+    return (it == _director_bitmaps.end()) ? empty : it->second;
+}
+
+const Bitmap &BasicCatalog::actor_bitmap(const string &actor) const {
+    static const Bitmap empty;
+    auto it = _actor_bitmaps.find(actor);
+    return (it == _actor_bitmaps.end()) ? empty : it->second;
+}
+
+vector<data::movie_ref> BasicCatalog::movies_by_actor(
+    const string &actor, size_t offset, size_t count
+) const {
+    return movies_in(actor_bitmap(actor), offset, count);
+}
+
+Bitmap BasicCatalog::year_bitmap(int min, int max) const {
+    vector<const Bitmap*> years;
+    auto end = _year_bitmaps.upper_bound(max);
+    for (auto it = _year_bitmaps.lower_bound(min); it != end; it++)
+        years.push_back(&it->second);
+    return Bitmap::union_of(years);
+}
+
+vector<data::movie_ref> BasicCatalog::movies_in(
+    const Bitmap &slots, size_t offset, size_t count
+) const {
+    vector<data::movie_ref> result;
+    if (count == 0) return result;
+
+    slots.for_each([&](uint32_t s) {
+        if (s >= _slots.size() || _slots[s].movie == nullptr) return true;
+        if (offset > 0) {
+            offset--;
+            return true;
+        }
+        result.push_back(ref(*_slots[s].movie));
+        return result.size() < count;
+    });
+    return result;
 }
 
 size_t BasicCatalog::size() const { return _data.size(); }
 
 optional<size_t> BasicCatalog::get_index(const string &title) const {
-    for (size_t i = 0; i < _data.size(); i++) {
-        if (_data[i].get()->title() == title) {
-            return i;
-        }
-    }
-    return nullopt;
+    auto it = _positions.find(title);
+    if (it == _positions.end()) return nullopt;
+    return it->second;
 }
 
 optional<data::movie_ref> BasicCatalog::get_movie(
@@ -225,6 +435,21 @@ vector<data::movie_ref> BasicCatalog::movies_slice(
     return result;
 }
 
+vector<data::movie_ref> BasicCatalog::movies_sorted(
+    sorting::field f, bool asc, size_t count, const optional<string> &after
+) const {
+    const sorting::SortedIndex &index = sorted_index(f);
+    if (!after.has_value()) return index.range(asc, 0, count);
+
+    optional<data::movie_ref> cursor = get_movie(after.value());
+    if (!cursor.has_value()) return {};
+    return index.range_after(cursor.value(), asc, count);
+}
+
+const sorting::SortedIndex &BasicCatalog::sorted_index(sorting::field f) const {
+    return _indexes.at(f);
+}
+
 vector<data::movie_ref> BasicCatalog::all_movies() const {
     vector<data::movie_ref> v;
     v.reserve(_data.size());
@@ -234,11 +459,13 @@ vector<data::movie_ref> BasicCatalog::all_movies() const {
 }
 
 void BasicCatalog::save(const string &filename) const {
-    ofstream out(filename);
-    if (!out.is_open()) throw runtime_error("Cannot open file: " + filename);
+    // write to a temporary file first: synopses may be read from `filename`
+    string temp_file = filename + ".tmp";
+    ofstream out(temp_file);
+    if (!out.is_open()) throw runtime_error("Cannot open file: " + temp_file);
 
     // write headers
-    csv::write_row(out, {
+    const vector<string> columns = {
         "title",
         "year",
         "category",
@@ -250,11 +477,15 @@ void BasicCatalog::save(const string &filename) const {
         "video_file",
         "normal_cover",
         "squared_cover"
-    });
+    };
+    csv::write_row(out, columns);
 
-    // write all movies
+    // write all movies, keeping the offset of their row
+    vector<streamoff> offsets;
+    offsets.reserve(_data.size());
     for (auto &mv: _data) {
         data::Movie *movie = mv.get();
+        offsets.push_back(out.tellp());
         csv::write_row(out, {
             movie->title(),
             to_string(movie->year()),
@@ -271,8 +502,22 @@ void BasicCatalog::save(const string &filename) const {
     }
 
     out.close();
+
+    // overwrite original file
+    if (std::rename(temp_file.c_str(), filename.c_str()) != 0)
+        throw runtime_error("Cannot replace the CSV file: " + filename);
+
+    auto column = [&columns](const string &name) -> size_t {
+        return distance(columns.begin(),
+                        find(columns.begin(), columns.end(), name));
+    };
+    saved(filename, offsets, column("title"), column("synopsis"));
 }
 
+void BasicCatalog::saved(
+    const string &, const vector<streamoff> &, size_t, size_t
+) const {}
+
 
 /*------------------------------------------
               CACHED CATALOG
@@ -288,7 +533,7 @@ CachedCatalog::CachedCatalog(const string &filename, size_t cache_size):
     _cache.reserve(cache_size);
 
     parse_csv(filename, [&](data::Movie &m)->void {
-        add (make_unique<data::Movie>(
+        auto movie = make_unique<data::Movie>(
             m.title(),
             m.year(),
             m.category(),
@@ -299,14 +544,30 @@ CachedCatalog::CachedCatalog(const string &filename, size_t cache_size):
             make_unique<data::CSVFileSynopsisProvider>(m.title(), filename),
             m.cover(),
             m.video_file()
-        ));
+        );
+        // the synopsis is read now, but not kept
+        movie->set_synopsis_hash(m.synopsis_hash());
+        add(move(movie));
     });
 }
 
 void CachedCatalog::add(unique_ptr<data::Movie> movie) {
+    use_cache(*movie);
+    BasicCatalog::add(move(movie));
+}
+
+vector<data::movie_ref> CachedCatalog::add_bulk(
+    vector<unique_ptr<data::Movie>> movies
+) {
+    for (auto &movie: movies)
+        use_cache(*movie);
+    return BasicCatalog::add_bulk(move(movies));
+}
+
+void CachedCatalog::use_cache(data::Movie &movie) {
     auto chgt_fct = [&](unique_ptr<data::SynopsisProvider> base) {
         return make_unique<CachedSynopsisProvider>(
-            movie.get()->title(),
+            movie.title(),
             move(base),
             [&](string t) -> string {
                 auto res = get_synopsis_using_cache(t);
@@ -314,8 +575,7 @@ void CachedCatalog::add(unique_ptr<data::Movie> movie) {
             });
     };
 
-    movie.get()->change_synopsis_provider(chgt_fct);
-    BasicCatalog::add(move(movie));
+    movie.change_synopsis_provider(chgt_fct);
 }
 
 void CachedCatalog::remove(const string &title) {
@@ -371,7 +631,7 @@ PagedCachedCatalog::PagedCachedCatalog(
     const string &filename, size_t cache_size
 ): _filename(filename), _cache_size(cache_size) {
     parse_csv(filename, [&](data::Movie &m)->void {
-        add(make_unique<data::Movie>(
+        auto movie = make_unique<data::Movie>(
             m.title(),
             m.year(),
             m.category(),
@@ -382,22 +642,37 @@ PagedCachedCatalog::PagedCachedCatalog(
             make_unique<data::CSVFileSynopsisProvider>(m.title(), filename),
             m.cover(),
             m.video_file()
-        ));
+        );
+        // the synopsis is read now, but not kept
+        movie->set_synopsis_hash(m.synopsis_hash());
+        add(move(movie));
     });
 }
 
 void PagedCachedCatalog::add(unique_ptr<data::Movie> movie) {
+    use_cache(*movie);
+    BasicCatalog::add(move(movie));
+}
+
+vector<data::movie_ref> PagedCachedCatalog::add_bulk(
+    vector<unique_ptr<data::Movie>> movies
+) {
+    for (auto &movie: movies)
+        use_cache(*movie);
+    return BasicCatalog::add_bulk(move(movies));
+}
+
+void PagedCachedCatalog::use_cache(data::Movie &movie) {
     auto chgt_fct = [&](unique_ptr<data::SynopsisProvider> base) {
         return make_unique<CachedSynopsisProvider>(
-            movie.get()->title(),
+            movie.title(),
             move(base),
             [&](string t) -> string {
                 auto res = get_synopsis_using_cache(t);
                 return (res.has_value()) ? res.value() : "";
             });
     };
-    movie.get()->change_synopsis_provider(chgt_fct);
-    BasicCatalog::add(move(movie));
+    movie.change_synopsis_provider(chgt_fct);
 }
 
 bool PagedCachedCatalog::is_cached(const string &title) const {
@@ -504,3 +779,62 @@ void PagedCachedCatalog::load_page(size_t index) {
     _cache[index] = page;
     _order.push_back(index);
 }
+
+
+/*------------------------------------------
+               LAZY CATALOG
+ -------------------------------------------*/
+
+LazyCatalog::LazyCatalog(const string &filename, size_t cache_size):
+    CachedCatalog(cache_size)
+{
+    parse_csv_rows(filename, true,
+        [&](data::Movie &m, const csv_location &loc)->void {
+            // rows without offset are looked up by title
+            unique_ptr<data::SynopsisProvider> provider;
+            if (loc.offset < 0)
+                provider = make_unique<data::CSVFileSynopsisProvider>(
+                    m.title(), filename);
+            else
+                provider = make_unique<data::IndexedCSVSynopsisProvider>(
+                    m.title(),
+                    filename,
+                    loc.offset,
+                    loc.title_column,
+                    loc.synopsis_column
+                );
+
+            auto movie = make_unique<data::Movie>(
+                m.title(),
+                m.year(),
+                m.category(),
+                m.producer(),
+                m.director(),
+                m.actors(),
+                m.duration(),
+                move(provider),
+                m.cover(),
+                m.video_file()
+            );
+            movie->set_synopsis_hash(m.synopsis_hash());
+            add(move(movie));
+        }
+    );
+}
+
+void LazyCatalog::saved(
+    const string &filename, const vector<streamoff> &offsets,
+    size_t title_column, size_t synopsis_column
+) const {
+    vector<data::movie_ref> movies = all_movies();
+    for (size_t i = 0; i < movies.size(); i++) {
+        // providers are wrapped by the cache (see CachedCatalog::use_cache)
+        data::SynopsisProvider *p = &movies[i].get().get_synopsis_provider().get();
+        if (auto *c = dynamic_cast<CachedSynopsisProvider*>(p))
+            p = &c->get_base_provider().get();
+
+        auto *indexed = dynamic_cast<data::IndexedCSVSynopsisProvider*>(p);
+        if (indexed && indexed->reads(filename))
+            indexed->relocate(offsets[i], title_column, synopsis_column);
+    }
+}
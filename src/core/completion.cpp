@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <queue>
+
+#include "core/completion.h"
+#include "core/utils.h"
+
+using namespace std;
+using namespace core;
+
+// Key of an entry in the ids map
+static string id_key(const string &key, Completion::field type) {
+    return char('0' + type) + key;
+}
+
+void Completion::add(const data::Movie &m) {
+    remove(m.title());
+
+    vector<pair<string, field>> values;
+    if (!m.title().empty()) values.push_back({m.title(), TITLE});
+    if (!m.director().empty()) values.push_back({m.director(), DIRECTOR});
+    for (const string &actor: m.actor_list()) values.push_back({actor, ACTOR});
+
+    for (auto &[text, type]: values) change(text, type, 1);
+    _movies[m.title()] = move(values);
+}
+
+void Completion::remove(const string &title) {
+    auto it = _movies.find(title);
+    if (it == _movies.end()) return;
+    for (auto &[text, type]: it->second) change(text, type, -1);
+    _movies.erase(it);
+}
+
+void Completion::clear() {
+    _entries.clear();
+    _ids.clear();
+    _free.clear();
+    _movies.clear();
+    _sorted.clear();
+    _added.clear();
+    _tree.clear();
+    _nb_removed = 0;
+}
+
+size_t Completion::size() const {
+    return _ids.size() - _nb_removed;
+}
+
+void Completion::change(const string &text, field type, int delta) {
+    string key = slug(text);
+    string ikey = id_key(key, type);
+    auto it = _ids.find(ikey);
+
+    if (it == _ids.end()) {
+        if (delta < 0) return;
+        entry e = {key, text, type, 1, NONE};
+        uint32_t id = _entries.size();
+        if (_free.empty()) _entries.push_back(move(e));
+        else {
+            id = _free.back();
+            _free.pop_back();
+            _entries[id] = move(e);
+        }
+        _ids[ikey] = id;
+        _added.push_back(id);
+        return;
+    }
+
+    // entries at weight 0 are dropped by the next rebuild
+    entry &e = _entries[it->second];
+    if (delta > 0) {
+        if (e.weight++ == 0) _nb_removed--;
+    }
+    else if (e.weight > 0 && --e.weight == 0) _nb_removed++;
+    if (e.pos != NONE) update_tree(e.pos);
+}
+
+bool Completion::less(uint32_t a, uint32_t b) const {
+    int c = _entries[a].key.compare(_entries[b].key);
+    return c < 0 || (c == 0 && _entries[a].type < _entries[b].type);
+}
+
+void Completion::rebuild() const {
+    auto removed = [this](uint32_t id) {
+        const entry &e = _entries[id];
+        if (e.weight > 0) return false;
+        _ids.erase(id_key(e.key, e.type));
+        _free.push_back(id);
+        return true;
+    };
+    if (_nb_removed > 0) {
+        _sorted.erase(remove_if(_sorted.begin(), _sorted.end(), removed),
+                      _sorted.end());
+        _added.erase(remove_if(_added.begin(), _added.end(), removed),
+                     _added.end());
+        _nb_removed = 0;
+    }
+
+    // only the new entries are sorted, then merged with the others
+    auto cmp = [this](uint32_t a, uint32_t b) { return less(a, b); };
+    sort(_added.begin(), _added.end(), cmp);
+    size_t middle = _sorted.size();
+    _sorted.insert(_sorted.end(), _added.begin(), _added.end());
+    inplace_merge(_sorted.begin(), _sorted.begin() + middle, _sorted.end(), cmp);
+    _added.clear();
+
+    size_t n = _sorted.size();
+    for (size_t i = 0; i < n; i++) _entries[_sorted[i]].pos = i;
+
+    // leaves are at n + i, each node keeps the best of its two children
+    _tree.assign(2 * n, 0);
+    for (size_t i = 0; i < n; i++) _tree[n + i] = i;
+    for (size_t i = n; i-- > 1;)
+        _tree[i] = best_of(_tree[2 * i], _tree[2 * i + 1]);
+}
+
+void Completion::update_tree(size_t pos) const {
+    size_t n = _sorted.size();
+    for (size_t i = (n + pos) / 2; i >= 1; i /= 2)
+        _tree[i] = best_of(_tree[2 * i], _tree[2 * i + 1]);
+}
+
+size_t Completion::best_of(size_t a, size_t b) const {
+    if (a >= _sorted.size()) return b;
+    if (b >= _sorted.size()) return a;
+    size_t wa = _entries[_sorted[a]].weight, wb = _entries[_sorted[b]].weight;
+    if (wa != wb) return wa > wb ? a : b;
+    return min(a, b);
+}
+
+size_t Completion::heaviest(size_t lo, size_t hi) const {
+    size_t n = _sorted.size();
+    size_t res = n;
+    for (lo += n, hi += n; lo < hi; lo /= 2, hi /= 2) {
+        if (lo & 1) res = best_of(res, _tree[lo++]);
+        if (hi & 1) res = best_of(res, _tree[--hi]);
+    }
+    return res;
+}
+
+vector<Completion::Suggestion> Completion::suggest(
+    const string &prefix, size_t k
+) const {
+    if (!_added.empty() || _nb_removed > 0) rebuild();
+
+    // range of the keys starting with the prefix
+    string p = slug(prefix);
+    auto first = lower_bound(_sorted.begin(), _sorted.end(), p,
+        [this](uint32_t id, const string &key) {
+            return _entries[id].key < key;
+        });
+    auto last = partition_point(first, _sorted.end(), [&](uint32_t id) {
+        return _entries[id].key.compare(0, p.size(), p) == 0;
+    });
+
+    // best entry of the range, then best entries of the ranges around it
+    struct range { size_t best, lo, hi; };
+    auto worse = [this](const range &a, const range &b) {
+        return best_of(a.best, b.best) == b.best;
+    };
+    priority_queue<range, vector<range>, decltype(worse)> ranges(worse);
+
+    auto push = [&](size_t lo, size_t hi) {
+        if (lo < hi) ranges.push({heaviest(lo, hi), lo, hi});
+    };
+    push(first - _sorted.begin(), last - _sorted.begin());
+
+    vector<Suggestion> res;
+    while (res.size() < k && !ranges.empty()) {
+        range r = ranges.top();
+        ranges.pop();
+        const entry &e = _entries[_sorted[r.best]];
+        res.push_back({e.text, e.type, e.weight});
+        push(r.lo, r.best);
+        push(r.best + 1, r.hi);
+    }
+    return res;
+}
@@ -23,10 +23,16 @@ MediaManager::MediaManager(
         _movies = new CachedCatalog(movies_csv_file, cache_size);
     else if (catalog_type == PAGED_CACHE)
         _movies = new PagedCachedCatalog(movies_csv_file, cache_size);
+    else if (catalog_type == LAZY_CACHE)
+        _movies = new LazyCatalog(movies_csv_file, cache_size);
     else
         _movies = new BasicCatalog(movies_csv_file);
 
     _csv_file = movies_csv_file;
+    for (auto &m: _movies->all_movies()) _completion.add(m.get());
+
+    // documents of another version are not found by their id anymore
+    if (_index->outdated()) _index->reindex_all(_movies->all_movies());
 }
 
 MediaManager::~MediaManager() {
@@ -53,30 +59,82 @@ vector<data::movie_ref> MediaManager::movies(
     return _movies->movies_slice(offset, count);
 }
 
+vector<data::movie_ref> MediaManager::movies(
+    const selection::Query &query, size_t offset, size_t count
+) const {
+    return query.run(_movies->all_movies(), offset, count);
+}
+
+vector<data::movie_ref> MediaManager::movies_by_actor(
+    const string &actor, size_t offset, size_t count
+) const {
+    return _movies->movies_by_actor(actor, offset, count);
+}
+
+shared_ptr<const selection::Facets> MediaManager::facets() const {
+    return _movies->facets();
+}
+
+vector<data::movie_ref> MediaManager::movies_sorted(
+    sorting::field f, bool ascending, size_t count,
+    const optional<string> &after
+) const {
+    return _movies->movies_sorted(f, ascending, count, after);
+}
+
+vector<Completion::Suggestion> MediaManager::suggest(
+    const string &prefix, size_t k
+) const {
+    return _completion.suggest(prefix, k);
+}
+
+search::Stats MediaManager::index_stats() const {
+    return _index->stats();
+}
+
 size_t MediaManager::nb_movies() const {
     return _movies->size();
 }
 
 void MediaManager::add(unique_ptr<data::Movie> m) {
+    // a title already in the catalog is ignored, by the indexes too
+    if (_movies->exists(m->title())) return;
     _index->add(*m);
+    _completion.add(*m);
     _movies->add(move(m));
 }
 
+void MediaManager::add_bulk(vector<unique_ptr<data::Movie>> movies) {
+    vector<data::movie_ref> added = _movies->add_bulk(move(movies));
+    _index->add_bulk(added);
+    for (auto &m: added) _completion.add(m.get());
+}
+
 void MediaManager::remove(const string &title) {
     _index->remove(title);
+    _completion.remove(title);
     _movies->remove(title);
 }
 
 void MediaManager::reindex(const string &title) {
     auto m = _movies->get_movie(title);
-    if (m.has_value())
+    if (m.has_value()) {
         _index->edit(title, m.value());
+        _completion.add(m.value().get());
+        _movies->refresh(title);
+    }
 }
 
-void MediaManager::reindex_all() {
-    _index->clear();
-    for (auto &m: _movies->all_movies())
-        _index->add(m);
+void MediaManager::reindex_all(
+    const search::Indexer::progress_callback &on_progress, size_t batch_size,
+    search::reindex_mode mode
+) {
+    vector<data::movie_ref> movies = _index->reindex_all(
+        _movies->all_movies(), batch_size, on_progress, mode);
+    for (auto &m: movies) {
+        _completion.add(m.get());
+        _movies->refresh(m.get().title());
+    }
 }
 
 void MediaManager::flush() {
@@ -96,3 +154,17 @@ vector<pair<data::movie_ref, double>> MediaManager::search(
     
     return vres;
 }
+
+SearchPage MediaManager::search_page(
+    string query, size_t offset, size_t count, search::order sort
+) const {
+    search::Page page = _index->search_page(query, offset, count, sort);
+    SearchPage res;
+    res.results.reserve(page.results.size());
+    res.matches = page.matches;
+
+    for (auto &r: page.results)
+        res.results.push_back({_movies->get_movie(r.first).value(), r.second});
+
+    return res;
+}
@@ -11,6 +11,24 @@ using namespace core::data;
 //                   MOVIE
 //----------------------------------------------------
 
+// Split a comma separated list of names, trimming spaces around each name
+static vector<string> parse_actors(const string &actors) {
+    vector<string> list;
+    size_t start = 0;
+    while (start <= actors.size()) {
+        size_t end = actors.find(',', start);
+        if (end == string::npos) end = actors.size();
+
+        size_t first = actors.find_first_not_of(" \t\r\n", start);
+        if (first != string::npos && first < end) {
+            size_t last = actors.find_last_not_of(" \t\r\n", end - 1);
+            list.push_back(actors.substr(first, last - first + 1));
+        }
+        start = end + 1;
+    }
+    return list;
+}
+
 Movie::Movie(
     const string &title, int year, const string &category, 
     const string &producer, const string &director, const string &actors,
@@ -18,8 +36,10 @@ Movie::Movie(
     const Cover &cover, const filesystem::path &video_file
 ): 
     _title(title), _year(year), _category(category), _producer(producer),
-    _director(director), _actors(actors), _duration(duration),
-    _synopsis(move(s_provider)), _cover(cover), _video_file(video_file) {}
+    _director(director), _actors(actors), _actor_list(parse_actors(actors)),
+    _duration(duration), _synopsis(move(s_provider)), _cover(cover),
+    _video_file(video_file), _title_key(slug(title)),
+    _category_key(slug(category)), _director_key(slug(director)) {}
 
 Movie::Movie(
     const string &title, int year, const string &category, 
@@ -28,21 +48,35 @@ Movie::Movie(
     const Cover &cover, const filesystem::path &video_file
 ): 
     _title(title), _year(year), _category(category), _producer(producer),
-    _director(director), _actors(actors), _duration(duration), _cover(cover),
-    _video_file(video_file)
+    _director(director), _actors(actors), _actor_list(parse_actors(actors)),
+    _duration(duration), _cover(cover), _video_file(video_file),
+    _title_key(slug(title)), _category_key(slug(category)),
+    _director_key(slug(director))
 {
     _synopsis = make_unique<DirectSynopsisProvider>(synopsis);
 }
 
 
-string Movie::title() const    { return _title; }
-int Movie::year() const        { return _year; }
-string Movie::producer() const { return _producer; }
-string Movie::category() const { return _category; }
-Cover Movie::cover() const     { return _cover; }
-string Movie::director() const { return _director; }
-string Movie::actors() const   { return _actors; }
-string Movie::synopsis() const { return _synopsis.get()->get_synopsis(); }
+const string &Movie::title() const    { return _title; }
+int Movie::year() const               { return _year; }
+const string &Movie::producer() const { return _producer; }
+const string &Movie::category() const { return _category; }
+Cover Movie::cover() const            { return _cover; }
+const string &Movie::director() const { return _director; }
+const string &Movie::actors() const   { return _actors; }
+const vector<string> &Movie::actor_list() const { return _actor_list; }
+const string &Movie::title_key() const    { return _title_key; }
+const string &Movie::category_key() const { return _category_key; }
+const string &Movie::director_key() const { return _director_key; }
+string Movie::synopsis() const {
+    string s = _synopsis.get()->get_synopsis();
+    if (!_synopsis_hash) _synopsis_hash = fnv1a(s);
+    return s;
+}
+uint64_t Movie::synopsis_hash() const {
+    if (!_synopsis_hash) synopsis();
+    return *_synopsis_hash;
+}
 filesystem::path Movie::video_file() const { return _video_file; }
 int Movie::duration() const    { return _duration; }
 string Movie::duration_str() const {
@@ -55,14 +89,25 @@ string Movie::duration_str() const {
 
 void Movie::set_year(int year)                   { _year = year; }
 void Movie::set_producer(const string &producer) { _producer = producer; }
-void Movie::set_category(const string &category) { _category = category; }
+void Movie::set_category(const string &category) {
+    _category = category;
+    _category_key = slug(category);
+}
 void Movie::set_cover(const Cover &cover)        { _cover = cover; }
-void Movie::set_director(const string &director) { _director = director; }
+void Movie::set_director(const string &director) {
+    _director = director;
+    _director_key = slug(director);
+}
 void Movie::set_duration(int duration)           { _duration = duration; }
-void Movie::set_actors(const string &actors)     { _actors = actors; }
+void Movie::set_actors(const string &actors) {
+    _actors = actors;
+    _actor_list = parse_actors(actors);
+}
 void Movie::set_synopsis(const string &synopsis) { 
     _synopsis.get()->set_synopsis(synopsis);
+    _synopsis_hash = fnv1a(synopsis);
 }
+void Movie::set_synopsis_hash(uint64_t hash) { _synopsis_hash = hash; }
 void Movie::set_video_file(const filesystem::path &path) { _video_file = path; }
 
 void Movie::change_synopsis_provider(function<
@@ -163,3 +208,44 @@ void CSVFileSynopsisProvider::set_synopsis(const string &synopsis) {
     if (r1 != 0 || r2 != 0) 
         throw runtime_error("Cannot replace the CSV file");
 }
+
+IndexedCSVSynopsisProvider::IndexedCSVSynopsisProvider(
+    const string &movie_title, const string &csv_filename,
+    streamoff offset, size_t title_column, size_t synopsis_column
+): CSVFileSynopsisProvider(movie_title, csv_filename), _offset(offset),
+   _title_column(title_column), _synopsis_column(synopsis_column) {}
+
+string IndexedCSVSynopsisProvider::get_synopsis() const {
+    ifstream fin(_csv_file);
+    if (!fin.is_open()) throw runtime_error("Cannot open CSV file");
+
+    auto row = csv::read_row_at(fin, _offset);
+    fin.close();
+
+    // the row has moved: fallback to a full lookup
+    if (!row.has_value()
+        || row->size() <= max(_title_column, _synopsis_column)
+        || row->at(_title_column) != _title
+    )
+        return CSVFileSynopsisProvider::get_synopsis();
+
+    return row->at(_synopsis_column);
+}
+
+bool IndexedCSVSynopsisProvider::reads(const string &csv_filename) const {
+    error_code ec;
+    return csv_filename == _csv_file
+        || filesystem::equivalent(csv_filename, _csv_file, ec);
+}
+
+streamoff IndexedCSVSynopsisProvider::offset() const {
+    return _offset;
+}
+
+void IndexedCSVSynopsisProvider::relocate(
+    streamoff offset, size_t title_column, size_t synopsis_column
+) {
+    _offset = offset;
+    _title_column = title_column;
+    _synopsis_column = synopsis_column;
+}
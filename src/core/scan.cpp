@@ -0,0 +1,206 @@
+#include <stdexcept>
+#include <memory>
+
+#include "core/scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define SCAN_X86
+    #include <immintrin.h>
+#endif
+
+// NEON is always there on AArch64. On 32 bits ARM (e.g. armhf, built for
+// ARMv6/ARMv7 without NEON), GCC compiles the kernel for NEON alone, and
+// it is only used if the CPU has it (see supported). GCC's arm_neon.h
+// enables NEON by itself; it needs a hardware FPU ABI (__ARM_FP).
+#if defined(__ARM_NEON)
+    #define SCAN_NEON
+    #define NEON_TARGET
+#elif defined(__arm__) && defined(__ARM_FP) && defined(__GNUC__) \
+      && !defined(__clang__)
+    #define SCAN_NEON
+    #define NEON_TARGET __attribute__((target("fpu=neon")))
+#endif
+
+#ifdef SCAN_NEON
+    #include <arm_neon.h>
+    #if !defined(__aarch64__)
+        #include <sys/auxv.h>
+        #include <asm/hwcap.h>
+    #endif
+#endif
+
+using namespace std;
+using namespace core;
+
+// Kernel: write the indexes of the values in [min; max] to `out` (which has
+// room for n indexes), and return their number.
+using kernel_func = size_t(*)(const int*, size_t, int, int, uint32_t*);
+
+// Write the indexes of the bits set in a 4 bits `mask`, offset by `base`
+// (branchless, as matches are unpredictable for wide intervals)
+static inline size_t emit4(uint32_t mask, size_t base, uint32_t *out, size_t k) {
+    for (uint32_t b = 0; b < 4; b++) {
+        out[k] = base + b;
+        k += (mask >> b) & 1;
+    }
+    return k;
+}
+
+// Scalar scan of [i; n[, appending after the k first indexes (branchless:
+// the index is always written, but only kept if the value matches)
+static size_t range_tail(
+    const int *values, size_t i, size_t n, int min, int max,
+    uint32_t *out, size_t k
+) {
+    for (; i < n; i++) {
+        out[k] = i;
+        k += (min <= values[i]) & (values[i] <= max);
+    }
+    return k;
+}
+
+static size_t range_scalar(
+    const int *values, size_t n, int min, int max, uint32_t *out
+) {
+    return range_tail(values, 0, n, min, max, out, 0);
+}
+
+#ifdef SCAN_X86
+
+__attribute__((target("sse2")))
+static size_t range_sse2(
+    const int *values, size_t n, int min, int max, uint32_t *out
+) {
+    const __m128i lo = _mm_set1_epi32(min), hi = _mm_set1_epi32(max);
+    size_t i = 0, k = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+        __m128i outside = _mm_or_si128(
+            _mm_cmpgt_epi32(lo, v), _mm_cmpgt_epi32(v, hi));
+        uint32_t mask = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+        k = emit4(mask, i, out, k);
+    }
+    return range_tail(values, i, n, min, max, out, k);
+}
+
+// For each 8 bits mask, positions of its set bits (then padding): used to
+// pack the matching indexes of a vector with a single permutation
+struct compress_table {
+    uint32_t positions[256][8];
+
+    compress_table() {
+        for (uint32_t mask = 0; mask < 256; mask++) {
+            size_t k = 0;
+            for (uint32_t b = 0; b < 8; b++)
+                if (mask & (1u << b)) positions[mask][k++] = b;
+            while (k < 8) positions[mask][k++] = 0;
+        }
+    }
+};
+
+__attribute__((target("avx2")))
+static size_t range_avx2(
+    const int *values, size_t n, int min, int max, uint32_t *out
+) {
+    static const compress_table table;
+    const __m256i lo = _mm256_set1_epi32(min), hi = _mm256_set1_epi32(max);
+    size_t i = 0, k = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+        __m256i outside = _mm256_or_si256(
+            _mm256_cmpgt_epi32(lo, v), _mm256_cmpgt_epi32(v, hi));
+        uint32_t mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF;
+
+        // store all 8 lanes (k+8 <= i+8 <= n), keep only the matching ones
+        __m256i pos = _mm256_loadu_si256(
+            (const __m256i*) table.positions[mask]);
+        _mm256_storeu_si256((__m256i*) (out + k),
+            _mm256_add_epi32(pos, _mm256_set1_epi32(i)));
+        k += __builtin_popcount(mask);
+    }
+    return range_tail(values, i, n, min, max, out, k);
+}
+
+#endif // SCAN_X86
+
+#ifdef SCAN_NEON
+
+NEON_TARGET
+static size_t range_neon(
+    const int *values, size_t n, int min, int max, uint32_t *out
+) {
+    const int32x4_t lo = vdupq_n_s32(min), hi = vdupq_n_s32(max);
+    static const uint32_t lanes[4] = {1, 2, 4, 8};
+    const uint32x4_t bits = vld1q_u32(lanes);
+
+    size_t i = 0, k = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(values + i);
+        uint32x4_t inside = vandq_u32(vcgeq_s32(v, lo), vcleq_s32(v, hi));
+
+        // one bit per lane, summed pairwise into a 4 bits mask
+        uint32x4_t m = vandq_u32(inside, bits);
+        uint32x2_t s = vpadd_u32(vget_low_u32(m), vget_high_u32(m));
+        s = vpadd_u32(s, s);
+        k = emit4(vget_lane_u32(s, 0), i, out, k);
+    }
+    return range_tail(values, i, n, min, max, out, k);
+}
+
+#endif // SCAN_NEON
+
+bool scan::supported(kernel k) {
+    switch (k) {
+        case SCALAR: return true;
+#ifdef SCAN_X86
+        case SSE2: return __builtin_cpu_supports("sse2");
+        case AVX2: return __builtin_cpu_supports("avx2");
+#endif
+#ifdef SCAN_NEON
+    #if defined(__aarch64__)
+        case NEON: return true;
+    #else
+        case NEON: return getauxval(AT_HWCAP) & HWCAP_NEON;
+    #endif
+#endif
+        default: return false;
+    }
+}
+
+scan::kernel scan::best_kernel() {
+    static const kernel best = []() {
+        for (kernel k: {AVX2, SSE2, NEON})
+            if (supported(k)) return k;
+        return SCALAR;
+    }();
+    return best;
+}
+
+static kernel_func get_kernel(scan::kernel k) {
+    switch (k) {
+#ifdef SCAN_X86
+        case scan::SSE2: return range_sse2;
+        case scan::AVX2: return range_avx2;
+#endif
+#ifdef SCAN_NEON
+        case scan::NEON: return range_neon;
+#endif
+        default: return range_scalar;
+    }
+}
+
+vector<uint32_t> scan::range(
+    kernel k, const int *values, size_t n, int min, int max
+) {
+    if (!supported(k))
+        throw invalid_argument("Unsupported scan kernel");
+
+    // uninitialized buffer: only the pages of the matches are touched
+    unique_ptr<uint32_t[]> buffer(new uint32_t[n]);
+    size_t count = get_kernel(k)(values, n, min, max, buffer.get());
+    return vector<uint32_t>(buffer.get(), buffer.get() + count);
+}
+
+vector<uint32_t> scan::range(const int *values, size_t n, int min, int max) {
+    return range(best_kernel(), values, n, min, max);
+}
@@ -1,48 +1,388 @@
+#include <unordered_set>
+#include <unordered_map>
+#include <cstdio>
+#include <algorithm>
+#include <future>
+#include <filesystem>
+#include <cctype>
+
 #include "core/search.h"
 #include "core/utils.h"
+#include "core/parallel.h"
 
 #include "xapian.h"
 
 using namespace std;
 using namespace core;
 
-search::Indexer::Indexer(const string &db_path, const string &lang): 
-    _db_path(db_path), _db(db_path, Xapian::DB_CREATE_OR_OPEN), _lang(lang) {
+// Value slots (sortable_serialise'd numbers, hash of the fields)
+namespace {
+    constexpr Xapian::valueno YEAR_SLOT = 0;
+    constexpr Xapian::valueno DURATION_SLOT = 1;
+    constexpr Xapian::valueno HASH_SLOT = 2;
+}
+
+// Version of the documents, part of their hash and stored in the database
+// metadata: to increase when prepare() or unique_id() change, so that the
+// next reindex rewrites them all (see outdated)
+namespace {
+    constexpr int DOCUMENT_VERSION = 2;
+    constexpr const char *VERSION_KEY = "document_version";
+}
+
+// Xapian terms are limited to 245 bytes: longer ids end with a hash
+namespace { constexpr size_t MAX_ID_SIZE = 200; }
+
+// Movies from which documents are prepared on several threads (unless
+// parallel::threshold() is lower): tokenizing the metadata alone of a movie
+// takes about 4 us, so starting 4 threads (about 75 us, see bench_parallel)
+// is paid back 4 times from about 100 movies.
+namespace { constexpr size_t PARALLEL_THRESHOLD = 100; }
+
+// Term prefixes of the fields (Xapian conventions: X for user-defined)
+namespace {
+    constexpr const char *TITLE_PREFIX = "S";
+    constexpr const char *CATEGORY_PREFIX = "XC";
+    constexpr const char *YEAR_PREFIX = "Y";
+    constexpr const char *DIRECTOR_PREFIX = "XD";
+    constexpr const char *PRODUCER_PREFIX = "XP";
+    constexpr const char *ACTOR_PREFIX = "XA";
+}
+
+search::Indexer::Indexer(
+    const string &db_path, const string &lang, size_t cache_size
+): 
+    _db_path(db_path), _db(db_path, Xapian::DB_CREATE_OR_OPEN), _lang(lang),
+    _cache_size(cache_size) {
     _termgen.set_stemmer(Xapian::Stem(lang));
+
+    // an empty database gets the current version, documents written by
+    // another version need a full reindex
+    string version = _db.get_metadata(VERSION_KEY);
+    if (version != to_string(DOCUMENT_VERSION)) {
+        if (_db.get_doccount() > 0) _outdated = true;
+        else {
+            _db.set_metadata(VERSION_KEY, to_string(DOCUMENT_VERSION));
+            _db.commit();
+        }
+    }
 }
 
 search::Indexer::~Indexer() {
-    _db.commit();
-    _db.close();
+    lock_guard<mutex> lock(_db_mutex);
+    try {
+        _db.commit();
+        _db.close();
+    }
+    catch (const Xapian::Error &) {
+        // closed by a failed clear: nothing to save
+    }
 }
 
 size_t search::Indexer::nb_terms() {
-    return distance(_db.allterms_begin(), _db.allterms_end());
+    return stats().nb_terms;
 }
 
+// Statistics of the documents seen by a reader
+static search::Stats read_stats(const Xapian::Database &db) {
+    search::Stats st;
+    st.nb_terms = distance(db.allterms_begin(), db.allterms_end());
+    st.nb_movies = db.get_doccount();
+    st.avg_length = db.get_avlength();
+    return st;
+}
+
+// Computed on a reader of the pool, without holding the writer lock: the
+// vocabulary walk does not block indexing nor searches.
+search::Stats search::Indexer::stats() const {
+    publish();
+    {
+        lock_guard<mutex> lock(_stats_mutex);
+        if (_stats.has_value() && _stats_commit == _commits)
+            return _stats.value();
+    }
+
+    unique_ptr<reader> r = acquire_reader();
+    Stats st;
+    try {
+        st = read_stats(r->db);
+    }
+    catch (const Xapian::DatabaseError &) {
+        // see search_uncached
+        reopen_reader(*r);
+        st = read_stats(r->db);
+    }
+    uint64_t commit = r->commit;
+    release_reader(move(r));
+
+    // a file removed meanwhile is skipped (file_size gives -1 on error)
+    error_code ec;
+    for (auto it = filesystem::recursive_directory_iterator(_db_path, ec);
+         !ec && it != filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        error_code file_ec;
+        if (!it->is_regular_file(file_ec)) continue;
+        uintmax_t size = it->file_size(file_ec);
+        if (!file_ec) st.disk_size += size;
+    }
+
+    // not kept if a newer commit has been read meanwhile
+    lock_guard<mutex> lock(_stats_mutex);
+    if (!_stats.has_value() || _stats_commit <= commit) {
+        _stats = st;
+        _stats_commit = commit;
+    }
+    return st;
+}
+
+void search::Indexer::changed(bool committed) {
+    _generation++;
+    if (committed) _commits++;
+    _dirty = !committed;
+}
+
+uint64_t search::Indexer::generation() const { return _generation; }
+
+bool search::Indexer::outdated() const { return _outdated; }
+
 size_t search::Indexer::nb_movies() {
+    lock_guard<mutex> lock(_db_mutex);
     return _db.get_doccount();
 }
 
-void search::Indexer::add(const data::movie_ref &f) {
+// Hash of strings (see core::fnv1a), each one followed by a separator
+// (0xff, not in UTF-8)
+static uint64_t fnv1a(initializer_list<const string*> strings) {
+    static const string separator = "\xff";
+    uint64_t h = core::fnv1a("");
+    for (const string *s: strings) h = core::fnv1a(separator, core::fnv1a(*s, h));
+    return h;
+}
+
+static string to_hex(uint64_t h) {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) h);
+    return hex;
+}
+
+// Hash of the indexed fields of a movie, in hexadecimal. The synopsis is
+// represented by its hash, known by the movie without reading it again.
+static string document_hash(const data::Movie &m) {
+    string y = to_string(m.year()), d = to_string(m.duration());
+    string s = to_hex(m.synopsis_hash()), v = to_string(DOCUMENT_VERSION);
+    return to_hex(fnv1a({&m.title(), &m.category(), &y, &m.director(),
+                         &m.producer(), &m.actors(), &s, &d, &v}));
+}
+
+// Indexed text of a movie. It is read on the calling thread: synopsis
+// providers may read files or caches which are not thread-safe.
+struct search::Indexer::fields {
+    string title, category, year, director, producer, actors, synopsis;
+    int year_value, duration;
+    string hash;
+
+    explicit fields(const data::Movie &m):
+        title(m.title()), category(m.category()), year(to_string(m.year())),
+        director(m.director()), producer(m.producer()), actors(m.actors()),
+        synopsis(m.synopsis()), year_value(m.year()), duration(m.duration()),
+        hash(document_hash(m)) {}
+};
+
+// Document ready to be written, with its unique id
+struct search::Indexer::prepared {
+    string id;
     Xapian::Document doc;
-    doc.set_data(f.get().title());
-    _termgen.set_document(doc);
+};
+
+// Id term of a movie: its exact title, as titles differing only by case
+// or accents are distinct movies
+static string unique_id(const string &title) {
+    if (title.size() <= MAX_ID_SIZE) return "Q" + title;
+    return "Q" + title.substr(0, MAX_ID_SIZE - 16) + to_hex(fnv1a({&title}));
+}
+
+search::Indexer::prepared search::Indexer::prepare(
+    Xapian::TermGenerator &termgen, const fields &f
+) {
+    prepared p{unique_id(f.title), Xapian::Document()};
+    p.doc.set_data(f.title);
+    termgen.set_document(p.doc);
+
+    termgen.index_text(f.title,    5); termgen.increase_termpos();
+    termgen.index_text(f.category, 3); termgen.increase_termpos();
+    termgen.index_text(f.year,     1); termgen.increase_termpos();
+    termgen.index_text(f.director, 2); termgen.increase_termpos();
+    termgen.index_text(f.producer, 2); termgen.increase_termpos();
+    termgen.index_text(f.actors,   4); termgen.increase_termpos();
+    termgen.index_text(f.synopsis, 1); termgen.increase_termpos();
+
+    // fields searched alone with "field:" (see search), with positions
+    // for phrases (e.g. director:"Marcel Pagnol")
+    termgen.index_text(f.title,    1, TITLE_PREFIX);    termgen.increase_termpos();
+    termgen.index_text(f.category, 1, CATEGORY_PREFIX); termgen.increase_termpos();
+    termgen.index_text(f.director, 1, DIRECTOR_PREFIX); termgen.increase_termpos();
+    termgen.index_text(f.producer, 1, PRODUCER_PREFIX); termgen.increase_termpos();
+    termgen.index_text(f.actors,   1, ACTOR_PREFIX);
+    p.doc.add_boolean_term(YEAR_PREFIX + f.year);
+
+    // filtered by ranges and sorted inside the match
+    p.doc.add_value(YEAR_SLOT, Xapian::sortable_serialise(f.year_value));
+    p.doc.add_value(DURATION_SLOT, Xapian::sortable_serialise(f.duration));
+    p.doc.add_value(HASH_SLOT, f.hash);
+
+    p.doc.add_boolean_term(p.id);
+    return p;
+}
+
+void search::Indexer::set_nb_workers(size_t n) { _nb_workers = n; }
+
+void search::Indexer::add(const data::movie_ref &f) {
+    fields fl(f.get());
+    lock_guard<mutex> lock(_db_mutex);
+    prepared p = prepare(_termgen, fl);
+    _db.replace_document(p.id, p.doc);
+    changed(false);
+}
+
+// Documents are prepared by batches while the previous batch is written:
+// fields are read here, then terms are generated on _nb_workers
+// workers (each owning a TermGenerator) by an asynchronous task, and the
+// calling thread is the only one writing to the database.
+void search::Indexer::write(
+    const vector<data::movie_ref> &movies,
+    size_t batch_size,
+    const progress_callback &on_progress
+) {
+    batch_size = max<size_t>(batch_size, 1);
+    size_t nb_workers = _nb_workers;
+    if (nb_workers == 0) nb_workers = parallel::nb_threads();
+    if (movies.size() < min(parallel::threshold(), PARALLEL_THRESHOLD))
+        nb_workers = 1;
+
+    // distinct objects: Xapian copies share their internals
+    vector<Xapian::TermGenerator> termgens(nb_workers);
+    for (auto &tg: termgens) tg.set_stemmer(Xapian::Stem(_lang));
+
+    auto prepare_batch = [&](size_t begin) {
+        size_t end = min(movies.size(), begin + batch_size);
+        vector<fields> batch;
+        batch.reserve(end - begin);
+        for (size_t i = begin; i < end; i++) batch.emplace_back(movies[i].get());
 
-    doc.set_data(f.get().title());
+        auto policy = (nb_workers > 1) ? launch::async : launch::deferred;
+        return async(policy, [&termgens, batch = move(batch)]() {
+            vector<prepared> docs(batch.size());
+            parallel::for_chunks(batch.size(), termgens.size(),
+                [&](size_t c, size_t b, size_t e) {
+                    for (size_t i = b; i < e; i++)
+                        docs[i] = prepare(termgens[c], batch[i]);
+                });
+            return docs;
+        });
+    };
 
-    _termgen.index_text(f.get().title(),           5); _termgen.increase_termpos();
-    _termgen.index_text(f.get().category(),        3); _termgen.increase_termpos();
-    _termgen.index_text(to_string(f.get().year()), 1); _termgen.increase_termpos();
-    _termgen.index_text(f.get().director(),        2); _termgen.increase_termpos();
-    _termgen.index_text(f.get().producer(),        2); _termgen.increase_termpos();
-    _termgen.index_text(f.get().actors(),          4); _termgen.increase_termpos();
-    _termgen.index_text(f.get().synopsis(),        1);
+    future<vector<prepared>> next;
+    if (!movies.empty()) next = prepare_batch(0);
 
-    std::string unique_id = "Q" + slug(f.get().title());
-    doc.add_boolean_term(unique_id);
+    for (size_t begin = 0; begin < movies.size(); begin += batch_size) {
+        vector<prepared> docs = next.get();
+        size_t end = begin + docs.size();
+        if (end < movies.size()) next = prepare_batch(end);
 
-    _db.replace_document(unique_id, doc);
+        {
+            lock_guard<mutex> lock(_db_mutex);
+            _db.begin_transaction();
+            try {
+                for (auto &p: docs)
+                    _db.replace_document(p.id, p.doc);
+                _db.commit_transaction();
+                changed(true);
+            }
+            catch (...) {
+                _db.cancel_transaction();
+                throw;
+            }
+        }
+
+        // unlocked: the callback may use the indexer
+        if (on_progress) on_progress(end, movies.size());
+    }
+}
+
+void search::Indexer::add_bulk(const vector<data::movie_ref> &movies) {
+    write(movies, movies.size(), nullptr);
+}
+
+vector<data::movie_ref> search::Indexer::reindex_all(
+    const vector<data::movie_ref> &movies,
+    size_t batch_size,
+    const progress_callback &on_progress,
+    reindex_mode mode
+) {
+    // 1. replace documents (changed ones only if incremental), one
+    //    transaction per batch. Hashes are compared without reading the
+    //    synopses: only the written movies are read.
+    bool outdated = _outdated;
+    vector<data::movie_ref> written = movies;
+    if (mode == INCREMENTAL && !outdated) {
+        unordered_map<string, string> hashes = stored_hashes();
+        written.clear();
+        for (auto &m: movies) {
+            auto it = hashes.find(unique_id(m.get().title()));
+            if (it == hashes.end() || it->second != document_hash(m.get()))
+                written.push_back(m);
+        }
+    }
+    write(written, batch_size, on_progress);
+
+    // 2. remove the documents of other movies (ids collected before deleting)
+    unordered_set<string> ids;
+    ids.reserve(movies.size());
+    for (auto &m: movies) ids.insert(unique_id(m.get().title()));
+
+    lock_guard<mutex> lock(_db_mutex);
+    vector<string> stale;
+    for (auto it = _db.allterms_begin("Q"); it != _db.allterms_end("Q"); ++it)
+        if (ids.count(*it) == 0) stale.push_back(*it);
+
+    if (!stale.empty() || outdated) {
+        _db.begin_transaction();
+        try {
+            for (auto &id: stale)
+                _db.delete_document(id);
+            // 3. all documents are now written by this version
+            if (outdated)
+                _db.set_metadata(VERSION_KEY, to_string(DOCUMENT_VERSION));
+            _db.commit_transaction();
+            changed(true);
+        }
+        catch (...) {
+            _db.cancel_transaction();
+            throw;
+        }
+        _outdated = false;
+    }
+    return written;
+}
+
+// Hashes are read from their value stream (docid order), then matched with
+// the ids, without loading any document
+unordered_map<string, string> search::Indexer::stored_hashes() const {
+    lock_guard<mutex> lock(_db_mutex);
+    unordered_map<Xapian::docid, string> by_doc;
+    by_doc.reserve(_db.get_doccount());
+    for (auto it = _db.valuestream_begin(HASH_SLOT);
+         it != _db.valuestream_end(HASH_SLOT); ++it)
+        by_doc[it.get_docid()] = *it;
+
+    unordered_map<string, string> hashes;
+    hashes.reserve(by_doc.size());
+    for (auto it = _db.allterms_begin("Q"); it != _db.allterms_end("Q"); ++it) {
+        Xapian::PostingIterator p = _db.postlist_begin(*it);
+        if (p == _db.postlist_end(*it)) continue;
+        auto h = by_doc.find(*p);
+        if (h != by_doc.end()) hashes[*it] = move(h->second);
+    }
+    return hashes;
 }
 
 void search::Indexer::edit(const string old_title, data::movie_ref &m) {
@@ -50,49 +390,256 @@ void search::Indexer::edit(const string old_title, data::movie_ref &m) {
 }
 
 void search::Indexer::remove(const string &title) {
-    string unique_id = "Q" + slug(title);
-    _db.delete_document(unique_id);
+    lock_guard<mutex> lock(_db_mutex);
+    _db.delete_document(unique_id(title));
+    changed(false);
 }
 
 void search::Indexer::flush() {
+    lock_guard<mutex> lock(_db_mutex);
     _db.commit();
+    changed(true);
 }
 
+// The database is replaced by an empty one, instead of deleting each
+// document (O(last docid), even for a nearly empty base). The empty
+// database is built aside, so the current one is untouched if that fails,
+// then renamed into place. Pooled readers keep their open files (the
+// previous database): they are opened again from the path on their next
+// search (see reopen_reader).
 void search::Indexer::clear() {
-    Xapian::docid maxid = _db.get_lastdocid();
-    for (Xapian::docid did = 1; did <= maxid; ++did)
-        try {
-            _db.delete_document(did);
-        }
-        catch(const Xapian::DocNotFoundError& e)  { /* Ignore exception */ }
+    lock_guard<mutex> lock(_db_mutex);
+    filesystem::path path = filesystem::path(_db_path).lexically_normal();
+    if (!path.has_filename()) path = path.parent_path();
+    filesystem::path tmp = path, old = path;
+    tmp += ".new";
+    old += ".old";
+
+    filesystem::remove_all(tmp);
+    {
+        Xapian::WritableDatabase empty(tmp.string(), Xapian::DB_CREATE_OR_OVERWRITE);
+        empty.set_metadata(VERSION_KEY, to_string(DOCUMENT_VERSION));
+        empty.commit();
+        empty.close();
+    }
+
+    // the write lock is released while the directories are swapped
+    _db.close();
+    try {
+        filesystem::remove_all(old);
+        filesystem::rename(path, old);
+        filesystem::rename(tmp, path);
+        _db = Xapian::WritableDatabase(_db_path, Xapian::DB_CREATE_OR_OPEN);
+    }
+    catch (...) {
+        // back to the previous database (or to the new one if in place)
+        error_code ec;
+        if (!filesystem::exists(path, ec)) filesystem::rename(old, path, ec);
+        _db = Xapian::WritableDatabase(_db_path, Xapian::DB_CREATE_OR_OPEN);
+        throw;
+    }
+
+    error_code ec;
+    filesystem::remove_all(old, ec);
+    _outdated = false;
+    _clears++;
+    changed(true);
+}
+
+// Spaces are not significant for the query parser: runs of spaces are
+// collapsed so that equivalent queries share their cache entry
+static string normalize_query(const string &query) {
+    string res;
+    res.reserve(query.size());
+    for (char c: query) {
+        bool space = isspace((unsigned char) c);
+        if (space && (res.empty() || res.back() == ' ')) continue;
+        res += space ? ' ' : c;
+    }
+    if (!res.empty() && res.back() == ' ') res.pop_back();
+    return res;
 }
 
 vector<pair<string, double>> search::Indexer::search(
     const string &query_str, size_t max_results
 ) const {
-    vector<pair<string, double>> results;
+    return search_page(query_str, 0, max_results).results;
+}
+
+search::Page search::Indexer::search_page(
+    const string &query_str, size_t offset, size_t count, order sort
+) const {
+    string key = to_string(sort) + ":" + to_string(offset) + ":"
+        + to_string(count) + ":" + normalize_query(query_str);
+    uint64_t generation = _generation;
+    {
+        lock_guard<mutex> lock(_cache_mutex);
+
+        // results of previous generations are dropped
+        if (_cache_generation != generation) {
+            _lru.clear();
+            _cached.clear();
+            _cache_generation = generation;
+        }
+
+        auto it = _cached.find(key);
+        if (it != _cached.end()) {
+            _lru.splice(_lru.begin(), _lru, it->second);
+            return it->second->second;
+        }
+    }
+
+    Page page = search_uncached(query_str, offset, count, sort);
+    if (_cache_size == 0) return page;
+
+    // not cached if the index has changed meanwhile
+    lock_guard<mutex> lock(_cache_mutex);
+    if (_cache_generation != generation || _cached.count(key) > 0)
+        return page;
+    if (_lru.size() >= _cache_size) {
+        _cached.erase(_lru.back().first);
+        _lru.pop_back();
+    }
+    _lru.emplace_front(key, page);
+    _cached[key] = _lru.begin();
+    return page;
+}
+
+// Parse and run a query on a database
+static search::Page run_query(
+    const Xapian::Database &db, const string &lang,
+    const string &query_str, size_t offset, size_t count, search::order sort
+) {
+    search::Page page;
 
     // Query parser
     Xapian::QueryParser qp;
-    qp.set_database(_db);
-    qp.set_stemmer(Xapian::Stem(_lang));
+    qp.set_database(db);
+    qp.set_stemmer(Xapian::Stem(lang));
     qp.set_stemming_strategy(Xapian::QueryParser::STEM_SOME);
 
+    // Fields (see prepare)
+    qp.add_prefix("title", TITLE_PREFIX);
+    qp.add_prefix("category", CATEGORY_PREFIX);
+    qp.add_prefix("director", DIRECTOR_PREFIX);
+    qp.add_prefix("producer", PRODUCER_PREFIX);
+    qp.add_prefix("actor", ACTOR_PREFIX);
+    qp.add_boolean_prefix("year", YEAR_PREFIX);
+    qp.add_rangeprocessor(
+        (new Xapian::NumberRangeProcessor(YEAR_SLOT, "year:"))->release());
+    qp.add_rangeprocessor(
+        (new Xapian::NumberRangeProcessor(DURATION_SLOT, "duration:"))
+            ->release());
+
     // Parse the query
     Xapian::Query query = qp.parse_query(query_str);
 
     // Perform the search
-    Xapian::Enquire enquire(_db);
+    Xapian::Enquire enquire(db);
     enquire.set_query(query);
 
-    Xapian::MSet matches = enquire.get_mset(0, max_results);
+    // sorted by value, then relevance for equal values
+    if (sort == search::YEAR_ASC || sort == search::YEAR_DESC)
+        enquire.set_sort_by_value_then_relevance(
+            YEAR_SLOT, sort == search::YEAR_DESC);
+    else if (sort == search::DURATION_ASC || sort == search::DURATION_DESC)
+        enquire.set_sort_by_value_then_relevance(
+            DURATION_SLOT, sort == search::DURATION_DESC);
+
+    Xapian::MSet matches = enquire.get_mset(offset, count);
+    page.matches.estimated = matches.get_matches_estimated();
+    page.matches.lower_bound = matches.get_matches_lower_bound();
+    page.matches.upper_bound = matches.get_matches_upper_bound();
 
     // Collect results with relevance score
+    page.results.reserve(matches.size());
     for (auto it = matches.begin(); it != matches.end(); it++) {
         double score = it.get_weight();             // relevance score
         string data = it.get_document().get_data(); // movie title
-        results.emplace_back(data, score);
+        page.results.emplace_back(data, score);
+    }
+
+    return page;
+}
+
+// Pending changes are committed if the writer is idle; if it is busy (e.g.
+// writing a batch), readers keep the last committed documents instead of
+// waiting.
+void search::Indexer::publish() const {
+    if (!_dirty) return;
+    unique_lock<mutex> lock(_db_mutex, try_to_lock);
+    if (lock.owns_lock() && _dirty) {
+        // same documents: cached results stay valid
+        _db.commit();
+        _commits++;
+        _dirty = false;
+    }
+}
+
+// Documents are searched with a read-only handle of the pool, so that
+// searches do not wait for each other nor for the writer.
+search::Page search::Indexer::search_uncached(
+    const string &query_str, size_t offset, size_t count, order sort
+) const {
+    publish();
+
+    unique_ptr<reader> r = acquire_reader();
+    Page page;
+    try {
+        page = run_query(r->db, _lang, query_str, offset, count, sort);
     }
+    catch (const Xapian::DatabaseError &) {
+        // the revision read has been overwritten by later commits (or the
+        // database has been replaced by clear)
+        reopen_reader(*r);
+        page = run_query(r->db, _lang, query_str, offset, count, sort);
+    }
+    release_reader(move(r));
+    return page;
+}
+
+unique_ptr<search::Indexer::reader> search::Indexer::acquire_reader() const {
+    unique_ptr<reader> r;
+    {
+        lock_guard<mutex> lock(_pool_mutex);
+        if (!_readers.empty()) {
+            r = move(_readers.back());
+            _readers.pop_back();
+        }
+    }
+
+    if (r == nullptr) {
+        r = make_unique<reader>();
+        open_reader(*r);
+    }
+    else if (r->commit != _commits || r->clears != _clears)
+        reopen_reader(*r);
+    return r;
+}
+
+// Under the writer lock: the directory is missing while clear swaps it
+void search::Indexer::open_reader(reader &r) const {
+    lock_guard<mutex> lock(_db_mutex);
+    r.commit = _commits;
+    r.clears = _clears;
+    r.db = Xapian::Database(_db_path);
+}
+
+void search::Indexer::reopen_reader(reader &r) const {
+    // a handle opened before a clear reads the files of the previous
+    // database (deleted, but still open): reopen() may not leave them
+    if (r.clears != _clears) return open_reader(r);
+
+    r.commit = _commits;
+    try {
+        r.db.reopen();
+    }
+    catch (const Xapian::DatabaseError &) {
+        open_reader(r);
+    }
+}
 
-    return results;
+void search::Indexer::release_reader(unique_ptr<reader> r) const {
+    lock_guard<mutex> lock(_pool_mutex);
+    _readers.push_back(move(r));
 }
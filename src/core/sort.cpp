@@ -1,13 +1,266 @@
 #include <algorithm>
+#include <string_view>
+#include <cstdint>
 
 #include "core/movie.h"
 #include "core/sort.h"
+#include "core/parallel.h"
+#include "core/utils.h"
 
 using namespace core;
 using namespace std;
 
 void sorting::sort(vector<data::movie_ref> &movies, sort_func fct) {
-    std::sort(movies.begin(), movies.end(), fct);
+    if (parallel::enabled(movies.size()))
+        parallel_sort(movies, fct, parallel::nb_threads());
+    else
+        std::sort(movies.begin(), movies.end(), fct);
+}
+
+// Merge sort: each thread sorts a chunk, then adjacent sorted chunks are
+// merged two by two (merges of a same round run in parallel).
+void sorting::parallel_sort(
+    vector<data::movie_ref> &movies, sort_func fct, size_t nb_threads
+) {
+    size_t n = movies.size();
+    size_t nb_chunks = max<size_t>(1, min(nb_threads, n));
+
+    // chunk bounds, as computed by parallel::for_chunks
+    vector<size_t> bounds(nb_chunks + 1);
+    for (size_t i = 0; i <= nb_chunks; i++) bounds[i] = n * i / nb_chunks;
+
+    // 1. sort each chunk
+    parallel::for_chunks(n, nb_chunks, [&](size_t, size_t b, size_t e) {
+        std::sort(next(movies.begin(), b), next(movies.begin(), e), fct);
+    });
+
+    // 2. merge sorted chunks
+    for (size_t width = 1; width < nb_chunks; width *= 2) {
+        size_t nb_merges = (nb_chunks + 2 * width - 1) / (2 * width);
+        parallel::for_chunks(nb_merges, nb_merges, [&](size_t m, size_t, size_t) {
+            size_t lo  = bounds[min(2 * m * width, nb_chunks)];
+            size_t mid = bounds[min((2 * m + 1) * width, nb_chunks)];
+            size_t hi  = bounds[min((2 * m + 2) * width, nb_chunks)];
+            inplace_merge(next(movies.begin(), lo), next(movies.begin(), mid),
+                          next(movies.begin(), hi), fct);
+        });
+    }
+}
+
+void sorting::top_k(vector<data::movie_ref> &movies, size_t k, sort_func fct) {
+    if (k >= movies.size()) {
+        sort(movies, fct);
+        return;
+    }
+
+    auto last = next(movies.begin(), k);
+    partial_sort(movies.begin(), last, movies.end(), fct);
+    movies.erase(last, movies.end());
+}
+
+void sorting::sort_range(
+    vector<data::movie_ref> &movies, size_t offset, size_t count, sort_func fct
+) {
+    if (offset >= movies.size()) {
+        movies.clear();
+        return;
+    }
+
+    auto first = next(movies.begin(), offset);
+    auto last = next(first, min(count, movies.size() - offset));
+
+    // 1. movies before `first` are the `offset` smallest ones
+    if (offset > 0)
+        nth_element(movies.begin(), first, movies.end(), fct);
+
+    // 2. sort only the range among the remaining movies
+    partial_sort(first, last, movies.end(), fct);
+
+    movies.erase(last, movies.end());
+    movies.erase(movies.begin(), first);
+}
+
+/*
+ * Key extraction sort
+ */
+
+// From this size, sorting by field uses the radix sort (see bench_sort)
+namespace { constexpr size_t RADIX_THRESHOLD = 512; }
+
+// Sorting key of a movie: field value and title, with their first bytes
+// packed in integers so that most comparisons stay inside the key array.
+struct extracted_key {
+    int number;            // numeric field value (year, duration)
+    uint64_t text_prefix;  // first 8 bytes of the text field value
+    uint64_t title_prefix; // first 8 bytes of the title
+    string_view text;      // text field value (category, director)
+    string_view title;     // title (tiebreak)
+    size_t index;          // position in the vector to sort
+};
+
+// 8 bytes from `from` in big endian (padded with 0): comparing prefixes
+// compares strings.
+static uint64_t prefix(string_view s, size_t from = 0) {
+    uint64_t p = 0;
+    for (size_t i = from; i < from + 8; i++)
+        p = (p << 8) | (i < s.size() ? (unsigned char) s[i] : 0);
+    return p;
+}
+
+// Compare strings with their prefixes: -1, 0 or 1
+static int compare(uint64_t p1, string_view s1, uint64_t p2, string_view s2) {
+    if (p1 != p2) return (p1 < p2) ? -1 : 1;
+    int c = s1.compare(s2);
+    return (c < 0) ? -1 : (c > 0);
+}
+
+static vector<extracted_key> extract_keys(
+    const vector<data::movie_ref> &movies, sorting::field f
+) {
+    vector<extracted_key> keys;
+    keys.reserve(movies.size());
+    for (size_t i = 0; i < movies.size(); i++) {
+        const data::Movie &m = movies[i].get();
+        extracted_key k = {0, 0, prefix(m.title()), {}, m.title(), i};
+        if (f == sorting::YEAR) k.number = m.year();
+        else if (f == sorting::DURATION) k.number = m.duration();
+        else if (f == sorting::CATEGORY) k.text = m.category();
+        else if (f == sorting::DIRECTOR) k.text = m.director();
+        k.text_prefix = prefix(k.text);
+        keys.push_back(k);
+    }
+    return keys;
+}
+
+// Order of keys (same order as sort_by(f, asc))
+static bool key_less(
+    const extracted_key &k1, const extracted_key &k2,
+    sorting::field f, bool asc
+) {
+    int c = (k1.number < k2.number) ? -1 : (k1.number > k2.number);
+    if (c == 0) c = compare(k1.text_prefix, k1.text, k2.text_prefix, k2.text);
+    if (c != 0) return asc ? c < 0 : c > 0;
+
+    c = compare(k1.title_prefix, k1.title, k2.title_prefix, k2.title);
+    return (asc || f != sorting::TITLE) ? c < 0 : c > 0;
+}
+
+// Reorder movies as given by the `index` member of sorted items
+template <typename Item>
+static void permute(vector<data::movie_ref> &movies, const vector<Item> &items) {
+    vector<data::movie_ref> sorted;
+    sorted.reserve(movies.size());
+    for (auto &it: items) sorted.push_back(movies[it.index]);
+    movies = move(sorted);
+}
+
+void sorting::sort(vector<data::movie_ref> &movies, field f, bool asc) {
+    if (movies.size() >= RADIX_THRESHOLD) {
+        radix_sort(movies, f, asc);
+        return;
+    }
+
+    vector<extracted_key> keys = extract_keys(movies, f);
+    std::sort(keys.begin(), keys.end(),
+        [f, asc](const extracted_key &k1, const extracted_key &k2) -> bool {
+            return key_less(k1, k2, f, asc);
+        });
+    permute(movies, keys);
+}
+
+/*
+ * Radix sort
+ */
+
+// Movie encoded as a 16 bytes code, such that comparing codes byte by byte
+// gives the sort order, except for ties (equal codes) which are resolved
+// by comparing the extracted keys.
+struct radix_item {
+    uint64_t code[2];
+    size_t index; // position in the vector to sort (and in the keys)
+};
+
+// Below this size, a bucket is sorted by comparisons
+namespace { constexpr size_t RADIX_CUTOFF = 64; }
+
+static unsigned byte_at(const radix_item &it, size_t b) {
+    return (it.code[b / 8] >> (56 - 8 * (b % 8))) & 0xFF;
+}
+
+// MSD radix sort of [first; last[ from byte `b`, using tmp as buffer
+template <typename Less>
+static void msd_sort(
+    radix_item *first, radix_item *last, radix_item *tmp, size_t b,
+    const Less &less
+) {
+    size_t n = last - first;
+    size_t count[256];
+
+    // skip bytes shared by all items (e.g. high bytes of a year)
+    for (;; b++) {
+        if (n <= RADIX_CUTOFF || b == 16) {
+            std::sort(first, last, less);
+            return;
+        }
+
+        fill(begin(count), end(count), 0);
+        for (radix_item *it = first; it != last; it++) count[byte_at(*it, b)]++;
+        if (count[byte_at(*first, b)] != n) break;
+    }
+
+    // scatter items in their bucket
+    size_t start[256];
+    for (size_t c = 0, pos = 0; c < 256; c++) {
+        start[c] = pos;
+        pos += count[c];
+    }
+    size_t pos[256];
+    copy(begin(start), end(start), begin(pos));
+    for (radix_item *it = first; it != last; it++)
+        tmp[pos[byte_at(*it, b)]++] = *it;
+    copy(tmp, tmp + n, first);
+
+    // sort each bucket on the next bytes
+    for (size_t c = 0; c < 256; c++)
+        if (count[c] > 1)
+            msd_sort(first + start[c], first + start[c] + count[c],
+                     tmp + start[c], b + 1, less);
+}
+
+void sorting::radix_sort(vector<data::movie_ref> &movies, field f, bool asc) {
+    vector<extracted_key> keys = extract_keys(movies, f);
+
+    // 1. encode keys: sort value first, then title if the value is exact
+    vector<radix_item> items(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        const extracted_key &k = keys[i];
+        uint64_t hi, lo;
+        if (f == YEAR || f == DURATION) {
+            // flipping the sign bit keeps the order of negative numbers
+            hi = (uint32_t) k.number ^ 0x80000000u;
+            lo = k.title_prefix;
+            if (!asc) hi = ~hi;
+        }
+        else {
+            string_view s = (f == TITLE) ? k.title : k.text;
+            hi = prefix(s);
+            lo = prefix(s, 8);
+            if (!asc) { hi = ~hi; lo = ~lo; }
+        }
+        items[i] = {{hi, lo}, i};
+    }
+
+    // 2. sort codes, equal codes are compared with the full keys
+    auto less = [&keys, f, asc](const radix_item &i1, const radix_item &i2) {
+        if (i1.code[0] != i2.code[0]) return i1.code[0] < i2.code[0];
+        if (i1.code[1] != i2.code[1]) return i1.code[1] < i2.code[1];
+        return key_less(keys[i1.index], keys[i2.index], f, asc);
+    };
+    vector<radix_item> tmp(items.size());
+    msd_sort(items.data(), items.data() + items.size(), tmp.data(), 0, less);
+
+    // 3. permute movies
+    permute(movies, items);
 }
 
 /*
@@ -16,127 +269,511 @@ void sorting::sort(vector<data::movie_ref> &movies, sort_func fct) {
 sorting::sort_func sorting::sort_by_title(bool asc) {
     if (asc)
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return m1.get().title() < m2.get().title();
+            return by(&data::Movie::title)(m1, m2);
         };
     else
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return sort_by_title(true)(m2, m1);
+            return by(&data::Movie::title, desc)(m1, m2);
         };
 }
 
 sorting::sort_func sorting::sort_by_year(bool asc) {
     if (asc)
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return (m1.get().year() < m2.get().year())
-            || (m1.get().year() == m2.get().year() 
-                && sort_by_title(true)(m1, m2));
+            return by(&data::Movie::year).then(&data::Movie::title)(m1, m2);
         };
     else
-        return [](const data::movie_ref m1, const data::movie_ref f2)-> bool {
-            return (m1.get().year() > f2.get().year())
-            || (m1.get().year() == f2.get().year() 
-                && sort_by_title(true)(m1, f2));
+        return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
+            return by(&data::Movie::year, desc)
+                .then(&data::Movie::title)(m1, m2);
         };
 }
 
 sorting::sort_func sorting::sort_by_category(bool asc) {
     if (asc)
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return (m1.get().category() < m2.get().category())
-            || (m1.get().category() == m2.get().category() 
-                && sort_by_title(true)(m1, m2));
+            return by(&data::Movie::category)
+                .then(&data::Movie::title)(m1, m2);
         };
     else
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return (m1.get().category() > m2.get().category())
-            || (m1.get().category() == m2.get().category() 
-                && sort_by_title(true)(m1, m2));
+            return by(&data::Movie::category, desc)
+                .then(&data::Movie::title)(m1, m2);
         };
 }
 
 sorting::sort_func sorting::sort_by_director(bool asc) {
     if (asc)
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return (m1.get().director() < m2.get().director())
-            || (m1.get().director() == m2.get().director() 
-                && sort_by_title(true)(m1, m2));
+            return by(&data::Movie::director)
+                .then(&data::Movie::title)(m1, m2);
         };
     else
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return (m1.get().director() > m2.get().director())
-            || (m1.get().director() == m2.get().director() 
-                && sort_by_title(true)(m1, m2));
+            return by(&data::Movie::director, desc)
+                .then(&data::Movie::title)(m1, m2);
         };
 }
 
 sorting::sort_func sorting::sort_by_duration(bool asc) {
     if (asc)
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return (m1.get().duration() < m2.get().duration())
-            || (m1.get().duration() == m2.get().duration()
-                && sort_by_title(true)(m1, m2));
+            return by(&data::Movie::duration)
+                .then(&data::Movie::title)(m1, m2);
         };
     else
         return [](const data::movie_ref m1, const data::movie_ref m2)-> bool {
-            return (m1.get().duration() > m2.get().duration())
-            || (m1.get().duration() == m2.get().duration()
-                && sort_by_title(true)(m1, m2));
+            return by(&data::Movie::duration, desc)
+                .then(&data::Movie::title)(m1, m2);
         };
 }
 
+sorting::sort_func sorting::sort_by(field f, bool asc) {
+    switch (f) {
+        case YEAR:     return sort_by_year(asc);
+        case CATEGORY: return sort_by_category(asc);
+        case DIRECTOR: return sort_by_director(asc);
+        case DURATION: return sort_by_duration(asc);
+        default:       return sort_by_title(asc);
+    }
+}
+
+
+/*
+ * Sorted index
+ */
+bool sorting::SortedIndex::key::operator<(const key &o) const {
+    if (number != o.number) return number < o.number;
+    if (text != o.text) return text < o.text;
+    if (movie == nullptr || o.movie == nullptr) return o.movie != nullptr;
+    if (movie->title() != o.movie->title())
+        return movie->title() < o.movie->title();
+    return std::less<data::Movie*>()(movie, o.movie);
+}
+
+sorting::SortedIndex::SortedIndex(field f): _field(f) {}
+
+sorting::SortedIndex::key sorting::SortedIndex::make_key(data::Movie &m) const {
+    switch (_field) {
+        case YEAR:     return {m.year(), "", &m};
+        case DURATION: return {m.duration(), "", &m};
+        case CATEGORY: return {0, m.category(), &m};
+        case DIRECTOR: return {0, m.director(), &m};
+        default:       return {0, "", &m};
+    }
+}
+
+void sorting::SortedIndex::insert(data::Movie &m) {
+    if (_positions.count(&m)) return;
+    _positions[&m] = _keys.insert(make_key(m)).first;
+}
+
+void sorting::SortedIndex::erase(const data::Movie &m) {
+    auto it = _positions.find(&m);
+    if (it == _positions.end()) return;
+    _keys.erase(it->second);
+    _positions.erase(it);
+}
+
+void sorting::SortedIndex::update(data::Movie &m) {
+    erase(m);
+    insert(m);
+}
+
+size_t sorting::SortedIndex::size() const { return _keys.size(); }
+
+// Descending orders keep titles ascending inside a group of equal values
+// (see sort_by_*), except for titles which are simply reversed.
+sorting::SortedIndex::iterator sorting::SortedIndex::first(bool asc) const {
+    if (asc || _keys.empty()) return _keys.begin();
+    if (_field == TITLE) return prev(_keys.end());
+    return group_begin(prev(_keys.end()));
+}
+
+sorting::SortedIndex::iterator sorting::SortedIndex::next(
+    iterator it, bool asc
+) const {
+    if (asc) return std::next(it);
+
+    if (_field == TITLE)
+        return (it == _keys.begin()) ? _keys.end() : prev(it);
+
+    // 1. next movie in the same group
+    auto n = std::next(it);
+    if (n != _keys.end() && n->number == it->number && n->text == it->text)
+        return n;
+
+    // 2. otherwise, first movie of the previous group
+    auto gb = group_begin(it);
+    return (gb == _keys.begin()) ? _keys.end() : group_begin(prev(gb));
+}
+
+sorting::SortedIndex::iterator sorting::SortedIndex::group_begin(
+    iterator it
+) const {
+    return _keys.lower_bound({it->number, it->text, nullptr});
+}
+
+vector<data::movie_ref> sorting::SortedIndex::collect(
+    iterator it, bool asc, size_t count
+) const {
+    vector<data::movie_ref> result;
+    result.reserve(min(count, _keys.size()));
+    for (; it != _keys.end() && result.size() < count; it = next(it, asc))
+        result.push_back(ref(*it->movie));
+    return result;
+}
+
+vector<data::movie_ref> sorting::SortedIndex::range(
+    bool asc, size_t offset, size_t count
+) const {
+    auto it = first(asc);
+    for (size_t i = 0; i < offset && it != _keys.end(); i++)
+        it = next(it, asc);
+    return collect(it, asc, count);
+}
+
+vector<data::movie_ref> sorting::SortedIndex::range_after(
+    const data::Movie &m, bool asc, size_t count
+) const {
+    auto it = _positions.find(&m);
+    if (it == _positions.end()) return {};
+    return collect(next(it->second, asc), asc, count);
+}
+
 
 /******************************************************************************/
 
-vector<data::movie_ref> selection::select_by_title(
-    const vector<data::movie_ref> &movies, const string &val
+// Keep movies matching `pred`, in their original order.
+// Large vectors are filtered by chunks in parallel, then concatenated.
+template <typename Predicate>
+static vector<data::movie_ref> filter(
+    const vector<data::movie_ref> &movies, Predicate pred
 ) {
     vector<data::movie_ref> vm = vector<data::movie_ref>();
-    for (data::movie_ref m: movies)
-        if (m.get().title() == val) vm.push_back(m);
+
+    if (!parallel::enabled(movies.size())) {
+        for (data::movie_ref m: movies)
+            if (pred(m.get())) vm.push_back(m);
+        return vm;
+    }
+
+    // 1. filter each chunk
+    size_t nb_chunks = parallel::nb_threads();
+    vector<vector<data::movie_ref>> parts(nb_chunks);
+    parallel::for_chunks(movies.size(), nb_chunks, 
+        [&](size_t c, size_t b, size_t e) {
+            for (size_t i = b; i < e; i++)
+                if (pred(movies[i].get())) parts[c].push_back(movies[i]);
+        });
+
+    // 2. concatenate results in chunks order
+    size_t total = 0;
+    for (auto &p: parts) total += p.size();
+    vm.reserve(total);
+    for (auto &p: parts) vm.insert(vm.end(), p.begin(), p.end());
     return vm;
 }
 
+vector<data::movie_ref> selection::select_by_title(
+    const vector<data::movie_ref> &movies, const string &val, match mode
+) {
+    if (mode == NORMALIZED) {
+        string key = slug(val);
+        return filter(movies, [&key](const data::Movie &m) {
+            return m.title_key() == key;
+        });
+    }
+    return filter(movies, [&val](const data::Movie &m) {
+        return m.title() == val;
+    });
+}
+
 vector<data::movie_ref> selection::select_by_year(
     const vector<data::movie_ref> &movies, int val, int delta
 ) {
-    vector<data::movie_ref> vm = vector<data::movie_ref>();
-
-    for (data::movie_ref m: movies)
-        if (val - delta <= m.get().year() && m.get().year() <= val + delta)
-            vm.push_back(m);
-    
-    return vm;
+    return filter(movies, [val, delta](const data::Movie &m) {
+        return val - delta <= m.year() && m.year() <= val + delta;
+    });
 }
 
 vector<data::movie_ref> selection::select_by_director(
+    const vector<data::movie_ref> &movies, const string &val, match mode
+) {
+    if (mode == NORMALIZED) {
+        string key = slug(val);
+        return filter(movies, [&key](const data::Movie &m) {
+            return m.director_key() == key;
+        });
+    }
+    return filter(movies, [&val](const data::Movie &m) {
+        return m.director() == val;
+    });
+}
+
+vector<data::movie_ref> selection::select_by_actor(
     const vector<data::movie_ref> &movies, const string &val
 ) {
-    vector<data::movie_ref> vm = vector<data::movie_ref>();
-    for (data::movie_ref m: movies)
-        if (m.get().director() == val) vm.push_back(m);
-    return vm;
+    return filter(movies, [&val](const data::Movie &m) {
+        const vector<string> &actors = m.actor_list();
+        return find(actors.begin(), actors.end(), val) != actors.end();
+    });
 }
 
 vector<data::movie_ref> selection::select_by_category(
-    const vector<data::movie_ref> &movies, const string &val
+    const vector<data::movie_ref> &movies, const string &val, match mode
 ) {
-    vector<data::movie_ref> vm = vector<data::movie_ref>();
-    for (data::movie_ref m: movies)
-        if (m.get().category() == val) vm.push_back(m);
-    return vm;
+    if (mode == NORMALIZED) {
+        string key = slug(val);
+        return filter(movies, [&key](const data::Movie &m) {
+            return m.category_key() == key;
+        });
+    }
+    return filter(movies, [&val](const data::Movie &m) {
+        return m.category() == val;
+    });
 }
 
 vector<data::movie_ref> selection::select_by_duration(
     const vector<data::movie_ref> &movies, int val, int delta
 ) {
-    vector<data::movie_ref> vm = vector<data::movie_ref>();
+    return filter(movies, [val, delta](const data::Movie &m) {
+        return val - delta <= m.duration() && m.duration() <= val + delta;
+    });
+}
+
+
+bool selection::Facets::operator==(const Facets &other) const {
+    return total == other.total && categories == other.categories
+        && years == other.years && directors == other.directors;
+}
+
+// Counts of text values: a linear search while there are few values (like
+// categories), which is cheaper than hashing, then a hash map (directors)
+namespace { constexpr size_t FEW_VALUES = 16; }
+
+class text_counter {
+public:
+    void add(string_view v) {
+        if (_many.empty()) {
+            for (auto &[value, n]: _few)
+                if (value == v) { n++; return; }
+            _few.emplace_back(v, 1);
+            if (_few.size() > FEW_VALUES) {
+                _many.insert(_few.begin(), _few.end());
+                _few.clear();
+            }
+            return;
+        }
+        _many[v]++;
+    }
+
+    void copy_to(map<string, size_t> &counts) const {
+        for (auto &[value, n]: _few) counts.emplace(value, n);
+        for (auto &[value, n]: _many) counts.emplace(value, n);
+    }
 
-    for (data::movie_ref m: movies)
-        if (
-            val - delta <= m.get().duration() 
-            && m.get().duration() <= val + delta
-        )
-            vm.push_back(m);
+private:
+    vector<pair<string_view, size_t>> _few;
+    unordered_map<string_view, size_t> _many;
+};
 
+// Years are counted in a hash map: any int is a valid year, so an array
+// over [min; max] could be huge for a single bad value
+selection::Facets selection::facets(const vector<data::movie_ref> &movies) {
+    text_counter categories, directors;
+    unordered_map<int, size_t> years;
+
+    for (data::movie_ref m: movies) {
+        categories.add(m.get().category());
+        directors.add(m.get().director());
+        years[m.get().year()]++;
+    }
+
+    Facets f;
+    f.total = movies.size();
+    categories.copy_to(f.categories);
+    directors.copy_to(f.directors);
+    f.years.insert(years.begin(), years.end());
+    return f;
+}
+
+/******************************************************************************/
+
+// Estimated selectivities: a title is unique, a director signs few movies,
+// and a year or a duration interval is compared to the usual spread.
+namespace {
+    constexpr double SELECTIVITY_TITLE    = 0.0001;
+    constexpr double SELECTIVITY_DIRECTOR = 0.01;
+    constexpr double SELECTIVITY_CATEGORY = 0.1;
+    constexpr double YEARS_SPREAD         = 100.0;
+    constexpr double DURATIONS_SPREAD     = 150.0;
+}
+
+selection::Query &selection::Query::add(criterion c) {
+    // stable insertion: equally selective criteria stay in call order
+    auto it = upper_bound(_criteria.begin(), _criteria.end(), c,
+        [](const criterion &c1, const criterion &c2) {
+            return c1.selectivity < c2.selectivity;
+        });
+    _criteria.insert(it, move(c));
+    return *this;
+}
+
+selection::Query &selection::Query::title(const string &val, match mode) {
+    if (mode == NORMALIZED)
+        return add({criterion::TITLE_KEY, slug(val), 0, 0, nullptr, SELECTIVITY_TITLE});
+    return add({criterion::TITLE, val, 0, 0, nullptr, SELECTIVITY_TITLE});
+}
+
+selection::Query &selection::Query::year(int val, int delta) {
+    double s = min(1.0, (2 * delta + 1) / YEARS_SPREAD);
+    return add({criterion::YEAR, "", val - delta, val + delta, nullptr, s});
+}
+
+selection::Query &selection::Query::category(const string &val, match mode) {
+    if (mode == NORMALIZED)
+        return add({criterion::CATEGORY_KEY, slug(val), 0, 0, nullptr, SELECTIVITY_CATEGORY});
+    return add({criterion::CATEGORY, val, 0, 0, nullptr, SELECTIVITY_CATEGORY});
+}
+
+selection::Query &selection::Query::director(const string &val, match mode) {
+    if (mode == NORMALIZED)
+        return add({criterion::DIRECTOR_KEY, slug(val), 0, 0, nullptr, SELECTIVITY_DIRECTOR});
+    return add({criterion::DIRECTOR, val, 0, 0, nullptr, SELECTIVITY_DIRECTOR});
+}
+
+selection::Query &selection::Query::duration(int val, int delta) {
+    double s = min(1.0, (2 * delta + 1) / DURATIONS_SPREAD);
+    return add({criterion::DURATION, "", val - delta, val + delta, nullptr, s});
+}
+
+selection::Query &selection::Query::where(
+    function<bool(const data::Movie&)> pred, double selectivity
+) {
+    return add({criterion::CUSTOM, "", 0, 0, move(pred), selectivity});
+}
+
+// Call `f` with the predicate of a criterion (as an inlinable lambda)
+template <typename F>
+static bool with_predicate(
+    const selection::Query::criterion &c, const F &f
+) {
+    using criterion = selection::Query::criterion;
+    switch (c.kind) {
+        case criterion::TITLE:
+            return f([&c](const data::Movie &m) { return m.title() == c.text; });
+        case criterion::YEAR:
+            return f([&c](const data::Movie &m) {
+                return c.min <= m.year() && m.year() <= c.max;
+            });
+        case criterion::CATEGORY:
+            return f([&c](const data::Movie &m) { return m.category() == c.text; });
+        case criterion::DIRECTOR:
+            return f([&c](const data::Movie &m) { return m.director() == c.text; });
+        case criterion::DURATION:
+            return f([&c](const data::Movie &m) {
+                return c.min <= m.duration() && m.duration() <= c.max;
+            });
+        case criterion::TITLE_KEY:
+            return f([&c](const data::Movie &m) { return m.title_key() == c.text; });
+        case criterion::CATEGORY_KEY:
+            return f([&c](const data::Movie &m) {
+                return m.category_key() == c.text;
+            });
+        case criterion::DIRECTOR_KEY:
+            return f([&c](const data::Movie &m) {
+                return m.director_key() == c.text;
+            });
+        case criterion::CUSTOM:
+            return f([&c](const data::Movie &m) { return c.pred(m); });
+    }
+    return false;
+}
+
+bool selection::Query::matches(const data::Movie &m) const {
+    for (const criterion &c: _criteria) {
+        bool ok = with_predicate(c, [&m](const auto &pred) { return pred(m); });
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// Movies are tested by blocks: each criterion is applied to the whole block
+// in a tight loop, then the next criterion only to the remaining movies.
+namespace { constexpr size_t QUERY_BLOCK_SIZE = 256; }
+
+template <typename Callback>
+void selection::Query::scan(
+    const vector<data::movie_ref> &movies, size_t begin, size_t end,
+    Callback on_match
+) const {
+    size_t sel[QUERY_BLOCK_SIZE];
+
+    for (size_t b = begin; b < end; b += QUERY_BLOCK_SIZE) {
+        size_t n = min<size_t>(QUERY_BLOCK_SIZE, end - b);
+        for (size_t i = 0; i < n; i++) sel[i] = b + i;
+
+        // keep indexes of movies matching each criterion
+        for (const criterion &c: _criteria) {
+            with_predicate(c, [&](const auto &pred) {
+                size_t k = 0;
+                for (size_t i = 0; i < n; i++)
+                    if (pred(movies[sel[i]].get())) sel[k++] = sel[i];
+                n = k;
+                return true;
+            });
+            if (n == 0) break;
+        }
+
+        for (size_t i = 0; i < n; i++)
+            if (!on_match(movies[sel[i]])) return;
+    }
+}
+
+vector<data::movie_ref> selection::Query::run(
+    const vector<data::movie_ref> &movies, size_t offset, size_t count
+) const {
+    vector<data::movie_ref> vm;
+    if (count == 0) return vm;
+
+    // whole result of a large vector: chunks are scanned in parallel
+    if (offset == 0 && count >= movies.size()
+        && parallel::enabled(movies.size())) {
+        size_t nb_chunks = parallel::nb_threads();
+        vector<vector<data::movie_ref>> parts(nb_chunks);
+        parallel::for_chunks(movies.size(), nb_chunks,
+            [&](size_t c, size_t b, size_t e) {
+                scan(movies, b, e, [&parts, c](data::movie_ref m) {
+                    parts[c].push_back(m);
+                    return true;
+                });
+            });
+
+        size_t total = 0;
+        for (auto &p: parts) total += p.size();
+        vm.reserve(total);
+        for (auto &p: parts) vm.insert(vm.end(), p.begin(), p.end());
+        return vm;
+    }
+
+    // a page: stopped once the page is full
+    scan(movies, 0, movies.size(), [&](data::movie_ref m) {
+        if (offset > 0) {
+            offset--;
+            return true;
+        }
+        vm.push_back(m);
+        return vm.size() < count;
+    });
     return vm;
 }
+
+size_t selection::Query::count(const vector<data::movie_ref> &movies) const {
+    size_t n = 0;
+    scan(movies, 0, movies.size(), [&n](data::movie_ref) {
+        n++;
+        return true;
+    });
+    return n;
+}
@@ -1,4 +1,8 @@
 #include <csv.h>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 
 #include "core/utils.h"
 
@@ -69,6 +73,113 @@ void core::csv::read(std::istream &in, row_callback on_row) {
     catch(const FoundException&) { /* do nothing, just stop parsing */ }
 }
 
+// Split the stream into raw rows, then parse each raw row with libcsv.
+// Row ends are found with the states of libcsv (non-strict): a quote only
+// opens a quoted field at the start of the field (after spaces), and such
+// a field only ends at a delimiter or a line end following a quote.
+// Each raw row must give exactly one row: otherwise, the rest of the stream
+// is parsed by libcsv alone, and given without offsets.
+void csv::read_indexed(std::istream &in, indexed_row_callback on_row) {
+    enum { ROW_NOT_BEGUN, FIELD_NOT_BEGUN, UNQUOTED, QUOTED, MIGHT_HAVE_ENDED }
+        state = ROW_NOT_BEGUN;
+    size_t spaces = 0; // spaces after a quote, in a quoted field
+
+    const streamoff start = in.tellg();
+    string raw_row;
+    streamoff row_start = start;
+    streamoff pos = start;
+    size_t nb_rows = 0; // rows given to the callback
+    char buf[1024];
+
+    // parse a complete raw row and give it to the callback
+    // (csv::read swallows FoundException, so it is caught here to stop)
+    bool stop = false, mismatch = false;
+    auto flush_row = [&]() {
+        vector<vector<string>> rows;
+        istringstream row_stream(raw_row);
+        csv::read(row_stream, [&rows](vector<string> &row) {
+            rows.push_back(move(row));
+        });
+        raw_row.clear();
+        if (rows.size() != 1) { mismatch = true; return; }
+        try { on_row(rows[0], row_start); }
+        catch(const FoundException&) { stop = true; }
+        nb_rows++;
+    };
+
+    while (!stop && !mismatch && in.good()) {
+        in.read(buf, sizeof(buf));
+        std::streamsize n = in.gcount();
+        if (n <= 0) break; // break if there is no readable character
+
+        for (std::streamsize i = 0; i < n && !stop && !mismatch; i++, pos++) {
+            char c = buf[i];
+            bool space = (c == ' ' || c == '\t');
+            bool end = (c == '\n' || c == '\r');
+
+            switch (state) {
+            case ROW_NOT_BEGUN:
+                // blank lines and leading spaces are skipped
+                if (space || end) continue;
+                row_start = pos;
+                state = (c == ',') ? FIELD_NOT_BEGUN
+                      : (c == '"') ? QUOTED : UNQUOTED;
+                break;
+            case FIELD_NOT_BEGUN:
+                if (c == '"') state = QUOTED;
+                else if (c != ',' && !space && !end) state = UNQUOTED;
+                break;
+            case UNQUOTED:
+                if (c == ',') state = FIELD_NOT_BEGUN;
+                break;
+            case QUOTED:
+                if (c == '"') { state = MIGHT_HAVE_ENDED; spaces = 0; }
+                break;
+            case MIGHT_HAVE_ENDED:
+                // "" is a quote, and any other character continues the field
+                if (c == ',') state = FIELD_NOT_BEGUN;
+                else if (space) spaces++;
+                else if (c == '"' && spaces > 0) spaces = 0;
+                else if (!end) state = QUOTED;
+                break;
+            }
+
+            if (end && state != QUOTED) {
+                flush_row();
+                state = ROW_NOT_BEGUN;
+                continue;
+            }
+            raw_row += c;
+        }
+    }
+
+    // treat leftover data
+    if (!stop && !mismatch && state != ROW_NOT_BEGUN) flush_row();
+
+    if (mismatch && !stop) {
+        in.clear();
+        in.seekg(start);
+        size_t skipped = 0;
+        csv::read(in, [&](vector<string> &row) {
+            if (skipped < nb_rows) { skipped++; return; }
+            on_row(row, -1);
+        });
+    }
+}
+
+optional<vector<string>> csv::read_row_at(istream &in, streamoff offset) {
+    in.clear();
+    in.seekg(offset);
+    if (!in.good()) return nullopt;
+
+    optional<vector<string>> result = nullopt;
+    csv::read(in, [&result](vector<string> &row) {
+        result = row;
+        throw csv::FoundException();
+    });
+    return result;
+}
+
 
 /**************************** WRITING *****************************/
 
@@ -182,35 +293,87 @@ void csv::edit_field(
 
 //----------------------------------------------------------------------------
 
+// ASCII equivalents of the Latin letters of U+00C0 to U+017F (Latin-1
+// Supplement and Latin Extended-A), by ranges of code points
+struct folding {
+    uint32_t first, last;
+    const char *ascii;
+};
+
+static const folding FOLDINGS[] = {
+    {0x00C0, 0x00C5, "a"}, {0x00C6, 0x00C6, "ae"}, {0x00C7, 0x00C7, "c"},
+    {0x00C8, 0x00CB, "e"}, {0x00CC, 0x00CF, "i"}, {0x00D0, 0x00D0, "d"},
+    {0x00D1, 0x00D1, "n"}, {0x00D2, 0x00D6, "o"}, {0x00D8, 0x00D8, "o"},
+    {0x00D9, 0x00DC, "u"}, {0x00DD, 0x00DD, "y"}, {0x00DE, 0x00DE, "th"},
+    {0x00DF, 0x00DF, "ss"},
+    {0x00E0, 0x00E5, "a"}, {0x00E6, 0x00E6, "ae"}, {0x00E7, 0x00E7, "c"},
+    {0x00E8, 0x00EB, "e"}, {0x00EC, 0x00EF, "i"}, {0x00F0, 0x00F0, "d"},
+    {0x00F1, 0x00F1, "n"}, {0x00F2, 0x00F6, "o"}, {0x00F8, 0x00F8, "o"},
+    {0x00F9, 0x00FC, "u"}, {0x00FD, 0x00FD, "y"}, {0x00FE, 0x00FE, "th"},
+    {0x00FF, 0x00FF, "y"},
+    {0x0100, 0x0105, "a"}, {0x0106, 0x010D, "c"}, {0x010E, 0x0111, "d"},
+    {0x0112, 0x011B, "e"}, {0x011C, 0x0123, "g"}, {0x0124, 0x0127, "h"},
+    {0x0128, 0x0131, "i"}, {0x0132, 0x0133, "ij"}, {0x0134, 0x0135, "j"},
+    {0x0136, 0x0138, "k"}, {0x0139, 0x0142, "l"}, {0x0143, 0x014B, "n"},
+    {0x014C, 0x0151, "o"}, {0x0152, 0x0153, "oe"}, {0x0154, 0x0159, "r"},
+    {0x015A, 0x0161, "s"}, {0x0162, 0x0167, "t"}, {0x0168, 0x0173, "u"},
+    {0x0174, 0x0175, "w"}, {0x0176, 0x0178, "y"}, {0x0179, 0x017E, "z"},
+    {0x017F, 0x017F, "s"}
+};
+
+static const char *fold(uint32_t cp) {
+    for (const folding &f: FOLDINGS)
+        if (f.first <= cp && cp <= f.last) return f.ascii;
+    return nullptr;
+}
+
+// Decode the UTF-8 sequence starting at src[i]: return its length and set
+// `cp`, or return 0 if the sequence is invalid
+static size_t decode_utf8(const string &src, size_t i, uint32_t &cp) {
+    unsigned char c = src[i];
+    size_t len = (c >= 0xC2 && c <= 0xDF) ? 2
+               : (c >= 0xE0 && c <= 0xEF) ? 3
+               : (c >= 0xF0 && c <= 0xF4) ? 4 : 0;
+    if (len == 0 || i + len > src.size()) return 0;
+
+    cp = c & (0xFF >> (len + 1));
+    for (size_t k = 1; k < len; k++) {
+        unsigned char cc = src[i + k];
+        if ((cc & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    return len;
+}
+
 string core::slug(const string &src) {
-    // List of special characters to replace
-    string old = "àâäéèëêîïùûüöôŷÿç";
-    // Corresponding replacement characters
-    string nw  = "aaaeeeeiiuuuooyyc";
-
-    // First pass: replace special characters with ASCII equivalents
-    string res = "";
-    for (size_t i = 0; i < src.size(); i++) {
-        size_t j = 0;
-        for (; j < old.size(); j+=2) {
-            // Check if current and next char match a special character pair
-            if (i != src.size()-1 && src[i] == old[j] && src[i+1] == old[j+1]) {
-                res += nw[j/2]; // Replace with corresponding ASCII char
-                i++;            // skip the next half-letter
-                break;
-            }
+    string res;
+    res.reserve(src.size());
+
+    for (size_t i = 0; i < src.size();) {
+        unsigned char c = src[i];
+
+        // ASCII: lowercase letters and digits, '_' otherwise
+        if (c < 0x80) {
+            if (isalnum(c)) res += (char) tolower(c);
+            else res += '_';
+            i++;
+            continue;
         }
 
-        // If no replacement was made, keep the original character
-        if (j == old.size()) res += src[i];
-    }
-    
-    // Second pass: lowercase all char and replace non-alphanumeric with '_'
-    for (size_t i = 0; i < res.size(); i++) {
-        res[i] = tolower(res[i]);
-        if ((res[i] < 'a' || 'z' < res[i]) && (res[i] < '0' || '9' < res[i]))
-            res[i] = '_';
+        // Latin letters are folded to ASCII; any other character (or invalid
+        // byte) gives one '_' per byte, as ids made of slugs rely on it
+        uint32_t cp = 0;
+        size_t len = decode_utf8(src, i, cp);
+        const char *ascii = (len > 0) ? fold(cp) : nullptr;
+        if (ascii != nullptr) res += ascii;
+        else res.append(max<size_t>(len, 1), '_');
+        i += max<size_t>(len, 1);
     }
-    
+
     return res;
 }
+
+uint64_t core::fnv1a(const string &src, uint64_t h) {
+    for (unsigned char c: src) h = (h ^ c) * 1099511628211ULL;
+    return h;
+}
@@ -0,0 +1,111 @@
+#include "core/bitmap.h"
+
+#include <iostream>
+#include <cassert>
+#include <functional>
+
+using namespace std;
+using namespace core;
+
+void test_add_remove() {
+    Bitmap b;
+    assert(b.empty() && b.cardinality() == 0);
+
+    b.add(3);
+    b.add(70000);
+    b.add(3);
+    b.add(1);
+    assert(b.cardinality() == 3);
+    assert(b.contains(1) && b.contains(3) && b.contains(70000));
+    assert(!b.contains(2) && !b.contains(4464));
+    assert(b.values() == vector<uint32_t>({1, 3, 70000}));
+
+    b.remove(3);
+    b.remove(5);
+    assert(b.cardinality() == 2 && !b.contains(3));
+    b.remove(70000);
+    b.remove(1);
+    assert(b.empty());
+}
+
+void test_dense() {
+    // more than 4096 values in a container: stored as a bitset
+    Bitmap b;
+    for (uint32_t i = 0; i < 20000; i += 2) b.add(i);
+    assert(b.cardinality() == 10000);
+    assert(b.contains(19998) && !b.contains(19999));
+
+    vector<uint32_t> v = b.values();
+    assert(v.size() == 10000 && v[0] == 0 && v[5000] == 10000);
+
+    // back to an array
+    for (uint32_t i = 0; i < 14000; i += 2) b.remove(i);
+    assert(b.cardinality() == 3000 && b.contains(14000) && !b.contains(0));
+
+    Bitmap b2;
+    for (uint32_t i = 14000; i < 20000; i += 2) b2.add(i);
+    assert(b == b2);
+
+    // around 4096 values: converted once each way, equal in both forms
+    Bitmap a, d;
+    for (uint32_t i = 0; i < 4096; i++) { a.add(i); d.add(i); }
+    d.add(4096);
+    d.remove(4096);
+    assert(a == d && d.cardinality() == 4096);
+    for (int k = 0; k < 100; k++) { d.add(5000); d.remove(5000); }
+    assert(a == d && d.values() == a.values());
+    for (uint32_t i = 0; i < 600; i++) { a.remove(i); d.remove(i); }
+    assert(a == d && d.cardinality() == 3496);
+
+    // early stop
+    size_t n = 0;
+    b.for_each([&n](uint32_t) { return ++n < 10; });
+    assert(n == 10);
+}
+
+void test_operations() {
+    // sparse and dense containers, over several high keys
+    Bitmap even, three, sparse;
+    for (uint32_t i = 0; i < 200000; i++) {
+        if (i % 2 == 0) even.add(i);
+        if (i % 3 == 0) three.add(i);
+        if (i % 97 == 0) sparse.add(i);
+    }
+
+    auto check = [](const Bitmap &b, const function<bool(uint32_t)> &in) {
+        size_t n = 0;
+        for (uint32_t i = 0; i < 200000; i++) {
+            assert(b.contains(i) == in(i));
+            n += in(i);
+        }
+        assert(b.cardinality() == n);
+    };
+
+    check(even & three, [](uint32_t i) { return i % 6 == 0; });
+    check(even | three, [](uint32_t i) { return i % 2 == 0 || i % 3 == 0; });
+    check(even & sparse, [](uint32_t i) { return i % 194 == 0; });
+    check(sparse | three, [](uint32_t i) { return i % 97 == 0 || i % 3 == 0; });
+    check(sparse & sparse, [](uint32_t i) { return i % 97 == 0; });
+
+    Bitmap b = even;
+    b &= three;
+    b |= sparse;
+    check(b, [](uint32_t i) { return i % 6 == 0 || i % 97 == 0; });
+
+    Bitmap u = Bitmap::union_of({&even, &three, &sparse});
+    assert(u == ((even | three) | sparse));
+    assert(Bitmap::union_of({&sparse}) == sparse);
+    assert(Bitmap::union_of({}).empty());
+
+    assert((even & Bitmap()).empty());
+    assert((even | Bitmap()) == even);
+}
+
+int main(void) {
+    test_add_remove();
+    test_dense();
+    test_operations();
+
+    cout << "TEST BITMAP : OK" << endl;
+    return 0;
+}
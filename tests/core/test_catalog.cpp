@@ -57,6 +57,20 @@ void test_basic_catalog() {
     assert(c1.size() == 4);
     assert(c1.all_movies().at(2).get().title() == "f3");
     assert(c1.all_movies().at(3).get().title() == "f5");
+    assert(c1.get_movie("f5").has_value() && !c1.get_movie("f4").has_value());
+
+    vector<unique_ptr<data::Movie>> batch;
+    for (string t: {"f3", "f6", "f7", "f6", "f4"})
+        batch.push_back(make_unique<data::Movie>(
+            t, 0, "", "", "", "", 0, "", data::Cover(), ""));
+    vector<data::movie_ref> added = c1.add_bulk(move(batch));
+    assert(added.size() == 3);
+    assert(added[0].get().title() == "f6");
+    assert(added[1].get().title() == "f7");
+    assert(added[2].get().title() == "f4");
+    assert(c1.size() == 7);
+    assert(c1.all_movies().at(6).get().title() == "f4");
+    assert(&c1.get_movie("f6").value().get() == &added[0].get());
 
     remove("./temp.csv");
 }
@@ -151,10 +165,172 @@ void test_paged_cached_catalog() {
     remove("./temp.csv");
 }
 
+void test_sorted_catalog() {
+    BasicCatalog c;
+    int years[] = {2001, 1999, 2010, 1999, 2005};
+    for (size_t i = 0; i < 5; i++)
+        c.add(make_unique<data::Movie>("f" + to_string(i), years[i], "", "",
+            "", "", 0, "", data::Cover(), ""));
+
+    auto page = c.movies_sorted(sorting::YEAR, false, 2);
+    assert(page.size() == 2);
+    assert(page[0].get().title() == "f2" && page[1].get().title() == "f4");
+
+    page = c.movies_sorted(sorting::YEAR, false, 2, page[1].get().title());
+    assert(page.size() == 2);
+    assert(page[0].get().title() == "f0" && page[1].get().title() == "f1");
+
+    page = c.movies_sorted(sorting::YEAR, false, 2, page[1].get().title());
+    assert(page.size() == 1 && page[0].get().title() == "f3");
+
+    page = c.movies_sorted(sorting::YEAR, false, 2, "f3");
+    assert(page.empty());
+    assert(c.movies_sorted(sorting::YEAR, false, 2, "unknown").empty());
+
+    // updated after changes
+    c.add(make_unique<data::Movie>("f5", 2020, "", "", "", "", 0, "",
+        data::Cover(), ""));
+    c.remove("f2");
+    c.get_movie("f3").value().get().set_year(2030);
+    c.refresh("f3");
+    page = c.movies_sorted(sorting::YEAR, false, 3);
+    assert(page.size() == 3);
+    assert(page[0].get().title() == "f3");
+    assert(page[1].get().title() == "f5");
+    assert(page[2].get().title() == "f4");
+
+    page = c.movies_sorted(sorting::TITLE, true, 10, "f1");
+    assert(page.size() == 3 && page[0].get().title() == "f3");
+}
+
+void test_bitmap_catalog() {
+    BasicCatalog c;
+    int years[] = {2001, 1999, 2010, 1999, 2005, 2003};
+    string categories[] = {"drame", "humour", "drame", "drame", "humour", "drame"};
+    for (size_t i = 0; i < 6; i++)
+        c.add(make_unique<data::Movie>("f" + to_string(i), years[i],
+            categories[i], "", "d" + to_string(i % 2),
+            "a" + to_string(i % 3) + ", a9", 0, "", data::Cover(), ""));
+
+    Bitmap b = c.category_bitmap("drame") & c.year_bitmap(1999, 2004);
+    assert(b.cardinality() == 3);
+    auto vm = c.movies_in(b);
+    assert(vm.size() == 3);
+    assert(vm[0].get().title() == "f0");
+    assert(vm[1].get().title() == "f3");
+    assert(vm[2].get().title() == "f5");
+    vm = c.movies_in(b, 1, 1);
+    assert(vm.size() == 1 && vm[0].get().title() == "f3");
+
+    b = c.director_bitmap("d1") | c.category_bitmap("humour");
+    assert(c.movies_in(b).size() == 4);
+    assert(c.category_bitmap("western").empty());
+    assert(c.year_bitmap(2011, 2020).empty());
+
+    // updated after changes
+    c.remove("f3");
+    c.get_movie("f5").value().get().set_category("humour");
+    c.refresh("f5");
+    c.add(make_unique<data::Movie>("f6", 2000, "drame", "", "d0", "", 0, "",
+        data::Cover(), ""));
+
+    vm = c.movies_in(c.category_bitmap("drame") & c.year_bitmap(1999, 2004));
+    assert(vm.size() == 2);
+    assert(vm[0].get().title() == "f0" && vm[1].get().title() == "f6");
+    assert(c.director_bitmap("d0").contains(3)); // slot of f3 reused by f6
+    assert(c.category_bitmap("humour").cardinality() == 3);
+    assert(c.year_bitmap(1999, 1999).cardinality() == 1);
+    assert(c.movies_in(c.director_bitmap("d1")).size() == 2);
+
+    // actor index
+    assert(c.actor_bitmap("a9").cardinality() == 5); // not f6
+    vm = c.movies_by_actor("a2");
+    assert(vm.size() == 2);
+    assert(vm[0].get().title() == "f2" && vm[1].get().title() == "f5");
+    assert(c.movies_by_actor("a9", 3, 10).size() == 2);
+    assert(c.movies_by_actor("a3").empty());
+    c.get_movie("f5").value().get().set_actors("a3");
+    c.refresh("f5");
+    assert(c.movies_by_actor("a2").size() == 1);
+    assert(c.movies_by_actor("a3").size() == 1);
+    assert(c.actor_bitmap("a9").cardinality() == 4);
+
+    // dense columns
+    c.get_movie("f4").value().get().set_year(1999);
+    c.refresh("f4");
+    vm = c.movies_by_year(2000, 1);
+    assert(vm.size() == 4);
+    assert(vm[0].get().title() == "f0");
+    assert(vm[1].get().title() == "f1");
+    assert(vm[2].get().title() == "f4");
+    assert(vm[3].get().title() == "f6");
+    assert(c.movies_by_year(2010).size() == 1);
+    assert(c.movies_by_duration(0).size() == c.size());
+    assert(c.movies_by_duration(10, 5).empty());
+
+    // facets, cached by version
+    auto f = c.facets();
+    assert(*f == selection::facets(c.all_movies()));
+    assert(f->total == 6 && f->categories.at("humour") == 3);
+    assert(f->years.at(1999) == 2 && f->directors.at("d0") == 4);
+    uint64_t version = c.version();
+    assert(c.facets() == f && c.version() == version);
+
+    // previous counts are kept by their holders
+    c.remove("f0");
+    assert(c.version() > version);
+    assert(c.facets()->total == 5 && c.facets()->directors.at("d0") == 3);
+    assert(c.facets()->years.count(2001) == 0);
+    assert(*c.facets() == selection::facets(c.all_movies()));
+    assert(f->total == 6 && f->directors.at("d0") == 4);
+}
+
+void test_lazy_catalog() {
+    BasicCatalog c;
+    for (size_t i = 0; i < 20; i++) {
+        string title = "f" + to_string(i);
+        string synopsis = "synopsis\n\"" + to_string(i) + "\"";
+        c.add(make_unique<data::Movie>(
+            title, 0, "", "", "", "", 10, synopsis, data::Cover(), ""));
+    }
+    c.save("./temp.csv");
+
+    LazyCatalog lc("./temp.csv", 2);
+    assert(lc.size() == 20);
+    assert(!lc.is_cached("f7"));
+
+    assert(lc.get_movie("f7").value().get().synopsis() == "synopsis\n\"7\"");
+    assert(lc.get_movie("f0").value().get().synopsis() == "synopsis\n\"0\"");
+    assert(lc.is_cached("f7") && lc.is_cached("f0"));
+
+    assert(lc.get_movie("f19").value().get().synopsis() == "synopsis\n\"19\"");
+    assert(!lc.is_cached("f7") && lc.is_cached("f0") && lc.is_cached("f19"));
+
+    // rows have moved: synopses are still found
+    lc.remove("f0");
+    lc.save("./temp.csv");
+    assert(lc.get_movie("f12").value().get().synopsis() == "synopsis\n\"12\"");
+
+    // offsets are those of the rewritten file
+    auto offset = [](const LazyCatalog &c, const string &title) {
+        auto &p = c.get_movie(title).value().get().get_synopsis_provider().get();
+        auto base = dynamic_cast<CachedSynopsisProvider&>(p).get_base_provider();
+        return dynamic_cast<data::IndexedCSVSynopsisProvider&>(base.get()).offset();
+    };
+    LazyCatalog reloaded("./temp.csv", 2);
+    for (const char *title: {"f1", "f12", "f19"})
+        assert(offset(lc, title) == offset(reloaded, title));
+
+    remove("./temp.csv");
+}
+
 int main(void) {
     test_basic_catalog();
     test_cached_catalog();
     test_paged_cached_catalog();
+    test_sorted_catalog();
+    test_bitmap_catalog();
+    test_lazy_catalog();
 
     cout << "TEST CATALOGUE : OK" << endl;
     return 0;
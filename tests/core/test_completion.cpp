@@ -0,0 +1,82 @@
+#include "core/completion.h"
+
+#include <iostream>
+#include <cassert>
+
+using namespace std;
+using namespace core;
+
+data::Movie movie(const string &title, const string &director,
+                  const string &actors) {
+    return data::Movie(title, 2000, "Drame", "", director, actors, 90, "",
+                       data::Cover(), "");
+}
+
+int main(void) {
+    Completion c;
+    assert(c.suggest("a", 10).empty());
+
+    data::Movie m1 = movie("Marius", "Alexander Korda", "Raimu, Pierre Fresnay");
+    data::Movie m2 = movie("Fanny", "Marc Allégret", "Raimu, Pierre Fresnay");
+    data::Movie m3 = movie("César", "Marcel Pagnol", "Raimu, Orane Demazis");
+    c.add(m1);
+    c.add(m2);
+    c.add(m3);
+    assert(c.size() == 9);
+
+    // most frequent first, then alphabetical order
+    auto s = c.suggest("ma", 10);
+    assert(s.size() == 3);
+    assert(s[0].text == "Marc Allégret" && s[0].type == Completion::DIRECTOR);
+    assert(s[1].text == "Marcel Pagnol" && s[2].text == "Marius");
+    assert(s[2].type == Completion::TITLE && s[2].weight == 1);
+    s = c.suggest("", 2);
+    assert(s.size() == 2);
+    assert(s[0].text == "Raimu" && s[0].weight == 3);
+    assert(s[1].text == "Pierre Fresnay" && s[1].weight == 2);
+
+    // case and accents are ignored
+    s = c.suggest("CÉS", 10);
+    assert(s.size() == 1 && s[0].text == "César");
+    s = c.suggest("marc all", 10);
+    assert(s.size() == 1 && s[0].text == "Marc Allégret");
+    assert(c.suggest("marcx", 10).empty());
+    assert(c.suggest("m", 1).size() == 1);
+
+    // removed and updated movies
+    c.remove("Fanny");
+    assert(c.suggest("raimu", 10)[0].weight == 2);
+    assert(c.suggest("marc all", 10).empty());
+    assert(c.suggest("fa", 10).empty());
+    c.remove("Fanny");
+    assert(c.size() == 7);
+
+    m3.set_actors("Orane Demazis, Pierre Fresnay");
+    c.add(m3);
+    s = c.suggest("", 10);
+    assert(s[0].text == "Pierre Fresnay" && s[0].weight == 2);
+    assert(c.suggest("raimu", 10)[0].weight == 1);
+
+    // new entries
+    c.add(m2);
+    c.add(movie("Topaze", "Marcel Pagnol", "Raimu"));
+    s = c.suggest("", 3);
+    assert(s[0].text == "Pierre Fresnay" && s[0].weight == 3);
+    assert(s[1].text == "Raimu" && s[1].weight == 3);
+    assert(s[2].text == "Marcel Pagnol" && s[2].weight == 2);
+
+
+    // weights updated in place
+    m1.set_actors("Pierre Fresnay");
+    c.add(m1);
+    s = c.suggest("", 2);
+    assert(s[0].text == "Pierre Fresnay" && s[0].weight == 3);
+    assert(s[1].text == "Marcel Pagnol" && s[1].weight == 2);
+    assert(c.suggest("rai", 10)[0].weight == 2);
+
+    c.clear();
+    assert(c.size() == 0 && c.suggest("", 10).empty());
+
+    cout << "TEST COMPLETION : OK" << endl;
+    return 0;
+}
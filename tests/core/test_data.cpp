@@ -33,7 +33,9 @@ void test_movie_accessors() {
     assert(m.cover().normal_path() == "path1.png");
     assert(m.cover().square_path() == "path2.png");
     assert(m.director() == "titi");
+    assert(m.title_key() == "flix" && m.director_key() == "titi");
     assert(m.actors().empty());
+    assert(m.actor_list().empty());
     assert(m.synopsis() == "empty movie");
     assert(m.duration() == 135);
     assert(m.duration_str() == "2h 15min");
@@ -81,11 +83,19 @@ void test_movie_mutators() {
     assert(m.cover().normal_path() == data::Cover().normal_path());
     assert(m.cover().square_path() == data::Cover().square_path());
     assert(m.director() == "toto");
+    assert(m.category_key() == "comedy" && m.director_key() == "toto");
     assert(m.actors() == "jack & john");
+    assert(m.actor_list() == vector<string>({"jack & john"}));
     assert(m.synopsis() == long_summary);
+    assert(m.synopsis_hash() == fnv1a(long_summary));
     assert(m.duration() == 25);
     assert(m.duration_str() == "25min");
     assert(m.video_file() == "movie2.mp4");
+
+    m.set_actors(" Raimu,Pierre Fresnay , , Orane Demazis,");
+    assert(m.actors() == " Raimu,Pierre Fresnay , , Orane Demazis,");
+    assert(m.actor_list() == vector<string>(
+        {"Raimu", "Pierre Fresnay", "Orane Demazis"}));
 }
 
 void test_movie_equality() {
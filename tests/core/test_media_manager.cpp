@@ -40,24 +40,78 @@ int main(void) {
     assert(mm->movies(2,2)[0].get().title() == "La Trilogie Marseillaise : César");
     assert(mm->movies(2,2)[1].get().title() == "La Fin du jour");
 
+    auto page = mm->movies_sorted(sorting::YEAR, false, 2);
+    assert(page.size() == 2);
+    assert(page[0].get().title() == "Germinal");
+    assert(page[1].get().title() == "La Fin du jour");
+    page = mm->movies_sorted(sorting::YEAR, false, 2, "La Fin du jour");
+    assert(page.size() == 2);
+    assert(page[0].get().title() == "J'accuse");
+    assert(page[1].get().title() == "La Trilogie Marseillaise : César");
+
+    auto q = selection::Query().category("Drame").year(1935, 5);
+    page = mm->movies(q, 0, 24);
+    assert(page.size() == 2);
+    assert(page[0].get().title() == "La Fin du jour");
+    assert(page[1].get().title() == "J'accuse");
+    page = mm->movies(q, 1, 24);
+    assert(page.size() == 1 && page[0].get().title() == "J'accuse");
+
 
     // --- indexer ---
 
     assert(mm->search("raimu").size() == 3);
+    SearchPage sp = mm->search_page("raimu", 1, 10);
+    assert(sp.results.size() == 2 && sp.matches.estimated == 3);
+    assert(&sp.results[0].first.get() == &mm->search("raimu")[1].first.get());
+    sp = mm->search_page("raimu year:1932..", 0, 10, search::YEAR_ASC);
+    assert(sp.results.size() == 2);
+    assert(sp.results[0].first.get().year() == 1932);
+    assert(sp.results[1].first.get().year() == 1936);
+    assert(mm->index_stats().nb_movies == 6);
+    assert(mm->suggest("raim").size() == 1);
+    assert(mm->suggest("raim")[0].weight == 3);
+
+    // a title already in the catalog is ignored, by the indexes too
+    mm->add(make_unique<data::Movie>("Germinal", 2001, "Western", "",
+        "Sergio Leone", "Clint Eastwood", 90, "", data::Cover(), ""));
+    assert(mm->get_movie("Germinal").value().get().year() == 1993);
+    assert(mm->suggest("clint").empty() && mm->suggest("sergio").empty());
+    assert(mm->search("eastwood").empty());
+    assert(mm->suggest("germinal").size() == 1);
     mm->remove("La Trilogie Marseillaise : Marius");
     assert(mm->nb_movies() == 5);
     assert(mm->search("raimu").size() == 2);
+    assert(mm->suggest("raim")[0].weight == 2);
+    assert(mm->suggest("la trilogie", 10).size() == 2);
 
     mm->get_movie("La Trilogie Marseillaise : César").value().get().set_actors("");
     assert(mm->search("raimu").size() == 2);
     mm->reindex("La Trilogie Marseillaise : César");
     assert(mm->search("raimu").size() == 1);
+    assert(mm->suggest("raimu")[0].weight == 1);
     mm->get_movie("La Trilogie Marseillaise : César").value().get().set_actors(
         "Raimu, Charpin, Demazis, Frenet"
     );
     mm->get_movie("Germinal").value().get().set_actors("Raimu");
     mm->reindex_all();
     assert(mm->search("raimu").size() == 3);
+    assert(mm->suggest("raimu")[0].weight == 3);
+
+    // incremental: only the changed movie is rewritten
+    mm->get_movie("Germinal").value().get().set_actors("");
+    mm->reindex_all(nullptr, 2, search::INCREMENTAL);
+    assert(mm->search("raimu").size() == 2);
+    assert(mm->suggest("raimu")[0].weight == 2);
+    mm->get_movie("Germinal").value().get().set_actors("Raimu");
+    mm->reindex_all(nullptr, 2, search::INCREMENTAL);
+    assert(mm->search("raimu").size() == 3);
+    assert(mm->suggest("raimu")[0].weight == 3);
+
+    mm->add_bulk(test::create_collection());
+    assert(mm->nb_movies() == 6);
+    assert(mm->search("raimu").size() == 4);
+    assert(mm->suggest("raimu")[0].weight == 4);
 
     filesystem::remove_all("./db");
     filesystem::remove("movies.csv");
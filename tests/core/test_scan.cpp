@@ -0,0 +1,67 @@
+#include "core/scan.h"
+
+#include <iostream>
+#include <cassert>
+#include <climits>
+#include <random>
+
+using namespace std;
+using namespace core;
+
+// expected result, computed with a plain loop
+vector<uint32_t> expected(const vector<int> &values, int min, int max) {
+    vector<uint32_t> res;
+    for (size_t i = 0; i < values.size(); i++)
+        if (min <= values[i] && values[i] <= max) res.push_back(i);
+    return res;
+}
+
+void test_kernels() {
+    assert(scan::supported(scan::SCALAR));
+    assert(scan::supported(scan::best_kernel()));
+
+    mt19937 gen(7);
+    uniform_int_distribution<int> year(1900, 2030);
+
+    // sizes not multiple of the vector widths, and extreme values
+    for (size_t n: {0, 1, 3, 4, 7, 8, 9, 31, 1000, 1003}) {
+        vector<int> values(n);
+        for (auto &v: values) v = year(gen);
+        if (n > 2) {
+            values[0] = INT_MIN;
+            values[n - 1] = INT_MAX;
+        }
+
+        for (scan::kernel k: {scan::SCALAR, scan::SSE2, scan::AVX2, scan::NEON}) {
+            if (!scan::supported(k)) continue;
+            const int *v = values.data();
+            assert(scan::range(k, v, n, 1990, 2000) == expected(values, 1990, 2000));
+            assert(scan::range(k, v, n, 2000, 2000) == expected(values, 2000, 2000));
+            assert(scan::range(k, v, n, 2000, 1990).empty());
+            assert(scan::range(k, v, n, INT_MIN, INT_MAX).size() == n);
+            assert(scan::range(k, v, n, INT_MIN, 1950) == expected(values, INT_MIN, 1950));
+            assert(scan::range(k, v, n, 2020, INT_MAX) == expected(values, 2020, INT_MAX));
+        }
+        assert(scan::range(values.data(), n, 1950, 1960) == expected(values, 1950, 1960));
+    }
+}
+
+void test_unsupported() {
+    for (scan::kernel k: {scan::SSE2, scan::AVX2, scan::NEON}) {
+        if (scan::supported(k)) continue;
+        int v = 0;
+        try {
+            scan::range(k, &v, 1, 0, 0);
+            assert(false);
+        }
+        catch(const invalid_argument &) {}
+    }
+}
+
+int main(void) {
+    test_kernels();
+    test_unsupported();
+
+    cout << "TEST SCAN : OK" << endl;
+    return 0;
+}
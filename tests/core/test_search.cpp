@@ -1,12 +1,35 @@
 #include "core/search.h"
+#include "core/parallel.h"
 #include "../utils.h"
 
 #include <iostream>
+#include <thread>
+#include <atomic>
 #include <cassert>
 
 using namespace std;
 using namespace core;
 
+// Synopsis provider counting the reads of another one
+class CountingSynopsisProvider: public data::SynopsisProvider {
+public:
+    CountingSynopsisProvider(
+        unique_ptr<data::SynopsisProvider> base, size_t &reads
+    ): _base(move(base)), _reads(reads) {}
+
+    string get_synopsis() const override {
+        _reads++;
+        return _base->get_synopsis();
+    }
+    void set_synopsis(const string &synopsis) override {
+        _base->set_synopsis(synopsis);
+    }
+
+private:
+    unique_ptr<data::SynopsisProvider> _base;
+    size_t &_reads;
+};
+
 int main(void) {
     search::Indexer *index = new search::Indexer("./index_db", "french");
 
@@ -18,6 +41,13 @@ int main(void) {
     size_t nb_terms = index->nb_terms();
     assert(nb_terms > 20);
 
+    // cached statistics, updated after changes
+    search::Stats st = index->stats();
+    assert(st.nb_movies == 6 && st.nb_terms == nb_terms);
+    assert(st.avg_length > 0);
+    index->flush();
+    assert(index->stats().disk_size > 0);
+
     data::Movie &m = *movies[5];
     auto m_ref = std::ref(m);
 
@@ -32,6 +62,7 @@ int main(void) {
     m_ref = std::ref(m5);
     index->remove(m5.title());
     assert(index->nb_movies() == 5);
+    assert(index->stats().nb_movies == 5);
     nb_terms = index->nb_terms();
     delete index;
 
@@ -48,6 +79,20 @@ int main(void) {
     assert(res[1].first == "J'accuse" || res[1].first == "La Fin du jour");
     assert(res[0].second > 1 && res[1].second > 1);
 
+    // cached results, dropped when the index changes
+    uint64_t generation = index->generation();
+    assert(index->search(" Victor  Francen\t") == res);
+    assert(index->search("Victor Francen", 1).size() == 1);
+    assert(index->generation() == generation);
+    index->remove("J'accuse");
+    assert(index->generation() > generation);
+    assert(index->search("Victor Francen").size() == 1);
+    // pending changes are committed by the search (seen by other handles)
+    assert(Xapian::Database("./index_db").get_doccount() == 5);
+    for (auto &mv: movies)
+        if (mv->title() == "J'accuse") index->add(ref(*mv));
+    assert(index->search("Victor Francen").size() == 2);
+
     res = index->search("1993");
     assert(res.size() == 1);
     assert(res[0].first == "Germinal");
@@ -58,13 +103,179 @@ int main(void) {
     assert(res[0].first == "La Fin du jour");
     assert(res[1].first == "La Trilogie Marseillaise : Fanny");
 
+    // pages of results, with the number of matches
+    search::Page page = index->search_page("jour", 1, 10);
+    assert(page.results.size() == 1 && page.results[0] == res[1]);
+    assert(page.matches.estimated == 2);
+    assert(page.matches.lower_bound <= 2 && page.matches.upper_bound >= 2);
+    page = index->search_page("jour", 0, 1);
+    assert(page.results.size() == 1 && page.results[0] == res[0]);
+    assert(page.matches.upper_bound == 2);
+    assert(index->search_page("jour", 2, 10).results.empty());
+
+    // fields, filters and order inside the match
+    assert(index->search("title:jour").size() == 1);
+    assert(index->search("gance").size() == 1);
+    assert(index->search("actor:gance").empty());
+    res = index->search("year:1936");
+    assert(res.size() == 1 && res[0].first == "La Trilogie Marseillaise : César");
+    assert(index->search("year:1930..1936").size() == 3);
+    assert(index->search("drame year:1930..1939").size() == 2);
+    assert(index->search("duration:..130").size() == 3);
+    page = index->search_page("year:1930..1939", 0, 10, search::YEAR_DESC);
+    assert(page.results.size() == 5);
+    assert(page.results[0].first == "La Fin du jour");
+    assert(page.results[1].first == "J'accuse");
+    assert(page.results[4].first == "La Trilogie Marseillaise : Marius");
+    page = index->search_page("category:drame", 0, 10, search::DURATION_DESC);
+    assert(page.results.size() == 2); // Germinal is "Fantastique" now
+    assert(page.results[0].first == "J'accuse");
+    assert(page.results[1].first == "La Fin du jour");
+    page = index->search_page("category:drame", 1, 10, search::DURATION_ASC);
+    assert(page.results.size() == 1 && page.matches.estimated == 2);
+    assert(page.results[0].first == "J'accuse");
+
     index->clear();
     assert(index->nb_movies() == 0);
     assert(index->nb_terms() == 0);
 
+    vector<data::movie_ref> refs;
+    for (auto &mv: movies) refs.push_back(ref(*mv));
+    index->add_bulk(refs);
+    assert(index->nb_movies() == 6);
+    assert(index->search("Victor Francen").size() == 2);
+
+    // batched reindex: progress after each batch, other movies removed
+    vector<pair<size_t, size_t>> progress;
+    auto on_progress = [&progress, &index](size_t done, size_t total) {
+        progress.push_back({done, total});
+        assert(index->nb_movies() >= done); // callback may use the indexer
+    };
+    index->reindex_all(refs, 4, on_progress);
+    assert(index->nb_movies() == 6);
+    assert(progress.size() == 2);
+    assert(progress[0].first == 4 && progress[0].second == 6);
+    assert(progress[1].first == 6 && progress[1].second == 6);
+    refs.pop_back();
+    index->reindex_all(refs, 1);
+    assert(index->nb_movies() == 5);
+    assert(index->search("Victor Francen").size() == 2);
+
+    // incremental reindex: only changed movies are written
+    uint64_t gen = index->generation();
+    progress.clear();
+    auto written = index->reindex_all(refs, 2, on_progress, search::INCREMENTAL);
+    assert(written.empty() && progress.empty());
+    assert(index->generation() == gen);
+    data::Movie &changed = refs[1].get();
+    changed.set_duration(changed.duration() + 1);
+    written = index->reindex_all(refs, 2, on_progress, search::INCREMENTAL);
+    assert(written.size() == 1 && &written[0].get() == &changed);
+    assert(progress.size() == 1 && progress[0].second == 1);
+    assert(index->reindex_all(refs, 2, nullptr, search::INCREMENTAL).empty());
+    data::movie_ref last = refs.back();
+    refs.pop_back();
+    assert(index->reindex_all(refs, 2, nullptr, search::INCREMENTAL).empty());
+    assert(index->nb_movies() == 4);
+    refs.push_back(last);
+    written = index->reindex_all(refs, 2, nullptr, search::INCREMENTAL);
+    assert(written.size() == 1 && &written[0].get() == &last.get());
+    assert(index->nb_movies() == 5);
+    data::Movie &edited = refs[2].get();
+    edited.set_synopsis(edited.synopsis() + " Version restaurée.");
+    written = index->reindex_all(refs, 2, nullptr, search::INCREMENTAL);
+    assert(written.size() == 1 && &written[0].get() == &edited);
+    assert(index->search("restaurée").size() == 1);
+
+    // an unchanged library is compared without reading the synopses
+    size_t reads = 0;
+    for (auto &r: refs)
+        r.get().change_synopsis_provider([&reads](auto base) {
+            return make_unique<CountingSynopsisProvider>(move(base), reads);
+        });
+    assert(index->reindex_all(refs, 2, nullptr, search::INCREMENTAL).empty());
+    assert(reads == 0);
+    assert(index->reindex_all(refs, 2).size() == 5 && reads == 5);
+
+    // parallel preparation of the documents: same index
+    parallel::set_threshold(1);
+    index->set_nb_workers(3);
+    nb_terms = index->nb_terms();
+    index->reindex_all(refs, 2);
+    assert(index->nb_movies() == 5 && index->nb_terms() == nb_terms);
+    assert(index->search("Victor Francen").size() == 2);
+    parallel::set_threshold(20000);
+    index->set_nb_workers(0);
+
+    // concurrent searches and statistics, while the same movies are
+    // indexed again
+    atomic<size_t> errors(0);
+    vector<thread> searchers;
+    for (size_t t = 0; t < 4; t++)
+        searchers.emplace_back([&]() {
+            for (size_t i = 0; i < 50; i++)
+                if (index->search("Victor Francen").size() != 2) errors++;
+        });
+    searchers.emplace_back([&]() {
+        for (size_t i = 0; i < 50; i++)
+            if (index->stats().nb_terms != nb_terms) errors++;
+    });
+    for (size_t i = 0; i < 10; i++) index->reindex_all(refs, 2);
+    for (auto &t: searchers) t.join();
+    assert(errors == 0);
+
+    // pooled readers opened before a clear see the new database
+    index->flush();
+    assert(index->search("Victor Francen").size() == 2);
+    index->clear();
+    assert(index->nb_movies() == 0);
+    assert(index->search("Victor Francen").empty());
+    assert(!filesystem::exists("./index_db.new"));
+    assert(!filesystem::exists("./index_db.old"));
+
+    // still usable, and the clear is persistent
+    index->add(refs[0]);
+    assert(index->nb_movies() == 1);
+    index->clear();
+    delete index;
+    index = new search::Indexer("./index_db", "french");
+    assert(index->nb_movies() == 0 && index->nb_terms() == 0);
+    assert(!index->outdated());
+
     delete index;
     filesystem::remove_all("./index_db");
 
+    // documents of another version (ids from the slug of the title) are
+    // all rewritten, and the old ones removed, by the next reindex
+    {
+        Xapian::WritableDatabase old("./old_db", Xapian::DB_CREATE_OR_OVERWRITE);
+        Xapian::Document doc;
+        doc.set_data("Germinal");
+        doc.add_boolean_term("Qgerminal");
+        old.replace_document("Qgerminal", doc);
+        old.commit();
+    }
+    index = new search::Indexer("./old_db", "french");
+    assert(index->outdated());
+    written = index->reindex_all(refs, 2, nullptr, search::INCREMENTAL);
+    assert(written.size() == refs.size() && !index->outdated());
+    assert(index->nb_movies() == refs.size());
+    delete index;
+    index = new search::Indexer("./old_db", "french");
+    assert(!index->outdated());
+
+    // titles differing only by case or accents are distinct movies
+    data::Movie a("Amélie", 2001, "", "", "", "", 0, "", data::Cover(), "");
+    data::Movie b("amelie", 2001, "", "", "", "", 0, "", data::Cover(), "");
+    index->add(ref(a));
+    index->add(ref(b));
+    assert(index->nb_movies() == refs.size() + 2);
+    index->remove("amelie");
+    assert(index->nb_movies() == refs.size() + 1);
+
+    delete index;
+    filesystem::remove_all("./old_db");
+
     cout << "TEST_SEARCH: OK" << endl;
     return 0;
 }
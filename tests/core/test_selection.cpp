@@ -1,7 +1,9 @@
 #include <iostream>
 #include <cassert>
+#include <climits>
 
 #include "core/sort.h"
+#include "core/parallel.h"
 
 using namespace std;
 using namespace core;
@@ -53,6 +55,93 @@ int main(void)
     assert(&res[0].get() == &m1);
     assert(&res[1].get() == &m2);
 
+    // actor lists: each name of the list is matched
+    data::Movie m4 = data::Movie(
+        "HIJ", 2005, "drame", "prodo", "reatos", "merde, aucuns",
+        90, "", data::Cover(), ".."
+    );
+    vector<data::movie_ref> actors = {ref(m1), ref(m2), ref(m3), ref(m4)};
+    res = selection::select_by_actor(actors, "aucuns");
+    assert(res.size() == 3 && &res[2].get() == &m4);
+    res = selection::select_by_actor(actors, "merde");
+    assert(res.size() == 2 && &res[0].get() == &m3 && &res[1].get() == &m4);
+    assert(selection::select_by_actor(actors, "aucun").empty());
+
+    // normalized match: case and accents are ignored
+    res = selection::select_by_title(vm, "abcdefgtitre");
+    assert(res.empty());
+    res = selection::select_by_title(vm, "abcdéfgTitre", selection::NORMALIZED);
+    assert(res.size() == 1 && &res[0].get() == &m3);
+    res = selection::select_by_category(vm, "HUMOUR", selection::NORMALIZED);
+    assert(res.size() == 2);
+    res = selection::select_by_director(vm, "Réatis", selection::NORMALIZED);
+    assert(res.size() == 2);
+    m2.set_director("Réâtis");
+    assert(m2.director_key() == "reatis");
+    res = selection::select_by_director(vm, "reatis", selection::NORMALIZED);
+    assert(res.size() == 2);
+    assert(selection::select_by_director(vm, "reatis").size() == 1);
+    m2.set_director("reatis");
+
+    // lazy queries
+    selection::Query q = selection::Query().year(2020).category("humour");
+    res = q.run(vm);
+    assert(res.size() == 1 && &res[0].get() == &m1);
+    assert(q.matches(m1) && !q.matches(m2) && !q.matches(m3));
+
+    q = selection::Query().director("reatis").duration(100, 15);
+    assert(q.count(vm) == 2);
+    res = q.run(vm, 1, 10);
+    assert(res.size() == 1 && &res[0].get() == &m2);
+    assert(q.run(vm, 0, 1).size() == 1 && &q.run(vm, 0, 1)[0].get() == &m1);
+    assert(q.run(vm, 2, 10).empty() && q.run(vm, 0, 0).empty());
+
+    size_t calls = 0;
+    q = selection::Query()
+        .where([&calls](const data::Movie &) { calls++; return true; })
+        .title("EFGH");
+    res = q.run(vm);
+    assert(res.size() == 1 && &res[0].get() == &m2);
+    assert(calls == 1); // most selective criterion first
+    assert(selection::Query().run(vm).size() == 3);
+    q = selection::Query().category("Humour", selection::NORMALIZED)
+        .title("ÀBCDtitre", selection::NORMALIZED);
+    res = q.run(vm);
+    assert(res.size() == 1 && &res[0].get() == &m1);
+    assert(!selection::Query().category("Humour").matches(m1));
+
+    // facets
+    selection::Facets f = selection::facets(vm);
+    assert(f.total == 3);
+    assert(f.categories.size() == 2);
+    assert(f.categories["humour"] == 2 && f.categories["drame"] == 1);
+    assert(f.years.size() == 2 && f.years[2020] == 2 && f.years[2011] == 1);
+    assert(f.directors["reatis"] == 2 && f.directors["reatos"] == 1);
+    assert(selection::facets({}).total == 0);
+
+    // far apart years, without an array over the whole range
+    data::Movie low("low", INT_MIN, "", "", "", "", 0, "", data::Cover(), "");
+    data::Movie high("high", INT_MAX, "", "", "", "", 0, "", data::Cover(), "");
+    f = selection::facets({ref(high), ref(low), ref(m1)});
+    assert(f.years.size() == 3 && f.years[INT_MIN] == 1 && f.years[INT_MAX] == 1);
+    assert(f.years.begin()->first == INT_MIN);
+
+    // parallel selection keeps the order
+    parallel::set_nb_threads(2);
+    parallel::set_threshold(0);
+    vector<data::movie_ref> many;
+    for (size_t i = 0; i < 100; i++) many.push_back(vm[i % 3]);
+    res = selection::select_by_year(many, 2020);
+    assert(res.size() == 67);
+    for (size_t i = 0; i < res.size(); i++)
+        assert(&res[i].get() == (i % 2 == 0 ? &m1 : &m2));
+    res = selection::select_by_category(many, "drame");
+    assert(res.size() == 33);
+    res = selection::Query().year(2020).duration(101).run(many);
+    assert(res.size() == 67 && &res[66].get() == &m1);
+    parallel::set_nb_threads(1);
+    parallel::set_threshold(20000);
+
     cout << "TEST SELECTION : OK" << endl;
     return 0;
 }
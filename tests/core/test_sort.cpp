@@ -1,7 +1,11 @@
 #include "core/sort.h"
+#include "core/parallel.h"
 
 #include <iostream>
 #include <cassert>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 using namespace core;
@@ -63,6 +67,217 @@ void duration_sort() {
     assert(&vm[0].get() == &m3 && &vm[1].get() == &m1 && &vm[2].get() == &m2);
 }
 
+void field_sort() {
+    assert(sorting::sort_by(sorting::TITLE, false) == sorting::sort_by_title(false));
+    assert(sorting::sort_by(sorting::YEAR, true) == sorting::sort_by_year(true));
+    assert(sorting::sort_by(sorting::DURATION, false) 
+        == sorting::sort_by_duration(false));
+}
+
+void partial_sort() {
+    vector<data::movie_ref> movies = vm;
+    sorting::top_k(movies, 2, sorting::sort_by_title(true));
+    assert(movies.size() == 2);
+    assert(&movies[0].get() == &m3 && &movies[1].get() == &m1);
+
+    movies = vm;
+    sorting::top_k(movies, 5, sorting::sort_by_year(true));
+    assert(movies.size() == 3);
+    assert(&movies[0].get() == &m3 && &movies[1].get() == &m1 
+        && &movies[2].get() == &m2);
+
+    movies = vm;
+    sorting::sort_range(movies, 1, 1, sorting::sort_by_title(false));
+    assert(movies.size() == 1 && &movies[0].get() == &m1);
+
+    movies = vm;
+    sorting::sort_range(movies, 1, 10, sorting::sort_by_duration(false));
+    assert(movies.size() == 2);
+    assert(&movies[0].get() == &m1 && &movies[1].get() == &m2);
+
+    movies = vm;
+    sorting::sort_range(movies, 3, 10, sorting::sort_by_duration(false));
+    assert(movies.empty());
+}
+
+void composed_sort() {
+    sorting::sort(vm, sorting::by(&data::Movie::year, sorting::desc)
+                          .then(&data::Movie::title));
+    assert(&vm[0].get() == &m1 && &vm[1].get() == &m2 && &vm[2].get() == &m3);
+
+    sorting::sort(vm, sorting::by(&data::Movie::producer)
+                          .then(&data::Movie::duration, sorting::desc)
+                          .then(&data::Movie::title, sorting::desc));
+    assert(&vm[0].get() == &m2 && &vm[1].get() == &m1 && &vm[2].get() == &m3);
+
+    auto title_size = [](const data::Movie &m) { return m.title().size(); };
+    sorting::sort(vm, sorting::by(title_size, sorting::asc));
+    assert(&vm[0].get() == &m2 && &vm[1].get() == &m1 && &vm[2].get() == &m3);
+
+    auto cmp = sorting::by(&data::Movie::category, sorting::desc)
+                   .then(&data::Movie::title);
+    assert(cmp(m3, m1) && !cmp(m1, m3) && !cmp(m1, m1) && cmp(m1, m2));
+}
+
+void key_sort() {
+    vector<unique_ptr<data::Movie>> movies;
+    vector<data::movie_ref> v1, v2;
+    for (int i = 0; i < 200; i++) {
+        movies.push_back(make_unique<data::Movie>(
+            "Long common title " + to_string(i * 7 % 200), 1990 + i % 13,
+            (i % 3) ? "Comédie dramatique" : "Comédie", "",
+            "Director with a long name " + to_string(i % 9), "", 60 + i % 50,
+            "", data::Cover(), ""));
+        v1.push_back(ref(*movies.back()));
+    }
+
+    sorting::field fields[] = {sorting::TITLE, sorting::YEAR,
+        sorting::CATEGORY, sorting::DIRECTOR, sorting::DURATION};
+
+    for (sorting::field f: fields)
+        for (bool asc: {true, false}) {
+            v2 = v1;
+            sorting::sort(v1, f, asc);
+            sorting::sort(v2, sorting::sort_by(f, asc));
+            for (size_t i = 0; i < v1.size(); i++)
+                assert(&v1[i].get() == &v2[i].get());
+        }
+
+    vm = {ref(m1), ref(m2), ref(m3)};
+    sorting::sort(vm, sorting::DIRECTOR, false);
+    assert(&vm[0].get() == &m3 && &vm[1].get() == &m1 && &vm[2].get() == &m2);
+}
+
+void parallel_sort() {
+    vector<unique_ptr<data::Movie>> movies;
+    vector<data::movie_ref> v1, v2;
+    for (int i = 0; i < 1000; i++) {
+        movies.push_back(make_unique<data::Movie>("t" + to_string(i * 7919 % 1000),
+            1990 + i % 13, "", "", "", "", 0, "", data::Cover(), ""));
+        v1.push_back(ref(*movies.back()));
+    }
+    v2 = v1;
+
+    // one thread per hardware thread by default
+    size_t hw = max<size_t>(thread::hardware_concurrency(), 1);
+    assert(parallel::nb_threads() == hw);
+    assert(parallel::threshold() == 20000);
+
+    parallel::set_nb_threads(3);
+    parallel::set_threshold(100);
+    assert(parallel::nb_threads() == 3 && parallel::enabled(100));
+    assert(!parallel::enabled(99));
+
+    for (size_t t: {1, 2, 3, 5, 8}) {
+        sorting::parallel_sort(v1, sorting::sort_by_year(false), t);
+        std::sort(v2.begin(), v2.end(), sorting::sort_by_year(false));
+        for (size_t i = 0; i < v1.size(); i++) assert(&v1[i].get() == &v2[i].get());
+        std::reverse(v1.begin(), v1.end());
+    }
+
+    sorting::sort(v1, sorting::sort_by_title(true));
+    for (size_t i = 1; i < v1.size(); i++) 
+        assert(v1[i-1].get().title() < v1[i].get().title());
+
+    // each element in exactly one chunk, errors rethrown after all chunks
+    vector<int> seen(7, 0);
+    parallel::for_chunks(7, 5, [&seen](size_t, size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) seen[i]++;
+    });
+    for (int x: seen) assert(x == 1);
+    bool thrown = false;
+    try {
+        parallel::for_chunks(7, 3, [&seen](size_t c, size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) seen[i]++;
+            if (c == 1) throw runtime_error("chunk");
+        });
+    }
+    catch (const runtime_error &) { thrown = true; }
+    assert(thrown);
+    for (int x: seen) assert(x == 2);
+
+    parallel::set_nb_threads(0);
+    assert(parallel::nb_threads() >= 1);
+    parallel::set_nb_threads(1);
+    parallel::set_threshold(20000);
+    assert(!parallel::enabled(1000000));
+}
+
+void sorted_index() {
+    vector<unique_ptr<data::Movie>> movies;
+    vector<data::movie_ref> refs;
+    for (int i = 0; i < 60; i++) {
+        movies.push_back(make_unique<data::Movie>(
+            "t" + to_string((i * 37) % 60), 1990 + i % 7, "c" + to_string(i % 4),
+            "", "d" + to_string(i % 5), "", 90 + i % 3, "", data::Cover(), ""));
+        refs.push_back(ref(*movies.back()));
+    }
+
+    sorting::field fields[] = {sorting::TITLE, sorting::YEAR,
+        sorting::CATEGORY, sorting::DIRECTOR, sorting::DURATION};
+
+    for (sorting::field f: fields) {
+        sorting::SortedIndex index(f);
+        for (auto &m: movies) index.insert(*m);
+        index.insert(*movies[0]);
+        assert(index.size() == 60);
+
+        movies[3]->set_year(2050); movies[3]->set_category("a");
+        movies[3]->set_director("z"); movies[3]->set_duration(10);
+        index.update(*movies[3]);
+        index.erase(*movies[10]);
+
+        for (bool asc: {true, false}) {
+            vector<data::movie_ref> expected;
+            for (auto &m: refs) if (&m.get() != movies[10].get()) 
+                expected.push_back(m);
+            sorting::sort(expected, sorting::sort_by(f, asc));
+
+            auto all = index.range(asc, 0, 100);
+            assert(all.size() == 59);
+            for (size_t i = 0; i < all.size(); i++)
+                assert(&all[i].get() == &expected[i].get());
+
+            auto page = index.range(asc, 20, 5);
+            assert(page.size() == 5 && &page[0].get() == &expected[20].get());
+
+            page = index.range_after(expected[40], asc, 30);
+            assert(page.size() == 18 && &page[0].get() == &expected[41].get());
+        }
+        assert(index.range_after(*movies[10], true, 5).empty());
+    }
+}
+
+void radix_sort() {
+    vector<unique_ptr<data::Movie>> movies;
+    vector<data::movie_ref> v1, v2;
+    for (int i = 0; i < 3000; i++) {
+        // long shared prefixes, equal keys and negative values
+        movies.push_back(make_unique<data::Movie>(
+            "Long common title " + to_string(i * 7 % 3000), 1900 + i * 13 % 120,
+            (i % 3) ? "Comédie dramatique" : "Comédie", "",
+            "Director with a long name " + to_string(i % 90), "",
+            (i % 11) ? i * 31 % 500 : -i, "", data::Cover(), ""));
+        v1.push_back(ref(*movies.back()));
+    }
+
+    sorting::field fields[] = {sorting::TITLE, sorting::YEAR,
+        sorting::CATEGORY, sorting::DIRECTOR, sorting::DURATION};
+
+    for (sorting::field f: fields)
+        for (bool asc: {true, false}) {
+            v2 = v1;
+            sorting::radix_sort(v1, f, asc);
+            std::sort(v2.begin(), v2.end(), sorting::sort_by(f, asc));
+            for (size_t i = 0; i < v1.size(); i++)
+                assert(&v1[i].get() == &v2[i].get());
+        }
+
+    v1.clear();
+    sorting::radix_sort(v1, sorting::YEAR, true);
+    assert(v1.empty());
+}
+
 int main(void)
 {
     title_sort();
@@ -70,6 +285,13 @@ int main(void)
     category_sort();
     director_sort();
     duration_sort();
+    field_sort();
+    partial_sort();
+    composed_sort();
+    key_sort();
+    radix_sort();
+    parallel_sort();
+    sorted_index();
 
     cout << "TEST SORT : OK" << endl;
     return 0;
@@ -148,6 +148,66 @@ void test_edit_field() {
     assert(counter == 12);
 }
 
+void test_read_indexed() {
+    vector<vector<string>> data = {
+        {"1", "abc", "&éàçê"}, 
+        {"154", "efg\nh", "bon..."},
+        {"48", "\"go\r\non'", "ok"}
+    };
+
+    stringstream ss;
+    csv::write_row(ss, {"A", "b", "c"});
+    csv::write(ss, data);
+
+    restart(ss);
+    vector<streamoff> offsets;
+    size_t i = 0;
+    csv::read_indexed(ss, [&](vector<string> &row, streamoff offset) {
+        if (i == 0) assert(row == vector<string>({"A", "b", "c"}));
+        else        assert(row == data[i-1]);
+        offsets.push_back(offset);
+        i++;
+    });
+    assert(i == 4);
+    assert(offsets[0] == 0);
+
+    for (size_t j = 1; j < offsets.size(); j++) {
+        auto row = csv::read_row_at(ss, offsets[j]);
+        assert(row.has_value() && row.value() == data[j-1]);
+    }
+    assert(!csv::read_row_at(ss, 100000).has_value());
+
+    // early stop
+    restart(ss);
+    i = 0;
+    csv::read_indexed(ss, [&](vector<string> &, streamoff) {
+        if (++i == 2) throw csv::FoundException();
+    });
+    assert(i == 2);
+
+    // quotes not written by write_row: same rows as libcsv
+    stringstream odd(
+        "a,b\"c,d\n"            // quote inside an unquoted field
+        "  \"x\"y\nz\",e\n"     // text after a quote: the field goes on
+        "\"p\" ,q\r\n"          // spaces after the closing quote
+        "\n   \n"
+        "last,\"\"\"\"\n");
+    vector<vector<string>> expected;
+    csv::read(odd, [&](vector<string> &row) { expected.push_back(row); });
+    assert(expected.size() == 4);
+
+    restart(odd);
+    offsets.clear();
+    i = 0;
+    csv::read_indexed(odd, [&](vector<string> &row, streamoff offset) {
+        assert(row == expected[i++] && offset >= 0);
+        offsets.push_back(offset);
+    });
+    assert(i == expected.size());
+    for (size_t j = 0; j < offsets.size(); j++)
+        assert(csv::read_row_at(odd, offsets[j]).value() == expected[j]);
+}
+
 void test_slug() {
     string s = "il était une fois !";
     s = slug(s);
@@ -156,6 +216,18 @@ void test_slug() {
     s = "Et PoUrTaNt (Il N'AiMe pAs çA !)";
     s = slug(s);
     assert(s == "et_pourtant__il_n_aime_pas_ca___");
+
+    // uppercase accents, ligatures, and other characters (one '_' per byte)
+    assert(slug("AMÉLIE à Œdipe, Ærø ß") == "amelie_a_oedipe__aero_ss");
+    assert(slug("Łódź 2€") == "lodz_2___");
+    assert(slug("a\xC3") == "a_" && slug("\xE9t\xE9") == "_t_");
+}
+
+void test_fnv1a() {
+    // reference values of the 64 bits FNV-1a hash
+    assert(fnv1a("") == 0xcbf29ce484222325ULL);
+    assert(fnv1a("a") == 0xaf63dc4c8601ec8cULL);
+    assert(fnv1a("b", fnv1a("a")) == fnv1a("ab"));
 }
 
 int main(void) {
@@ -163,7 +235,9 @@ int main(void) {
     test_read();
     test_get_field();
     test_edit_field();
+    test_read_indexed();
     test_slug();
+    test_fnv1a();
 
     cout << "TEST CSV : OK" << endl;
     return 0;